@@ -0,0 +1,115 @@
+#ifndef ALIGNMENT_HPP
+#define ALIGNMENT_HPP
+
+#include <QVector>
+#include <algorithm>
+#include "time_series.hpp"
+
+// Alignment of time series sampled at different dates. Every date vector must be sorted in ascending order, so the
+// joins are a single merge pass over both inputs.
+
+enum class JoinMode { exact, asof };
+
+// Row of `dates` that has the same date as each element of `target`. -1 when the date is missing.
+
+inline auto merge_join_index(const QVector<qint64>& target, const QVector<qint64>& dates) -> QVector<int> {
+  QVector<int> output(target.size(), -1);
+
+  int m = 0;
+
+  for (int n = 0; n < target.size(); n++) {
+    while (m < dates.size() && dates[m] < target[n]) {
+      m++;
+    }
+
+    if (m < dates.size() && dates[m] == target[n]) {
+      output[n] = m;
+    }
+  }
+
+  return output;
+}
+
+// Last row of `dates` not after each element of `target` (last observation carried forward). -1 before the first
+// observation.
+
+inline auto asof_join_index(const QVector<qint64>& target, const QVector<qint64>& dates) -> QVector<int> {
+  QVector<int> output(target.size(), -1);
+
+  int m = 0;
+
+  for (int n = 0; n < target.size(); n++) {
+    while (m < dates.size() && dates[m] <= target[n]) {
+      m++;
+    }
+
+    output[n] = m - 1;
+  }
+
+  return output;
+}
+
+template <class T>
+auto gather(const QVector<T>& values, const QVector<int>& index, const T& fill) -> QVector<T> {
+  QVector<T> output(index.size(), fill);
+
+  for (int n = 0; n < index.size(); n++) {
+    if (index[n] >= 0) {
+      output[n] = values[index[n]];
+    }
+  }
+
+  return output;
+}
+
+// The last n dates found in at least one of the series
+
+inline auto latest_dates(const QVector<TimeSeries const*>& series, const int& n) -> QVector<qint64> {
+  QVector<qint64> output;
+
+  for (auto& s : series) {
+    const auto start = s->tail_start(n);
+
+    const auto middle = output.size();
+
+    output.append(s->dates.mid(start));
+
+    std::inplace_merge(output.begin(), output.begin() + middle, output.end());
+
+    output.erase(std::unique(output.begin(), output.end()), output.end());
+
+    if (output.size() > n) {
+      output.remove(0, output.size() - n);
+    }
+  }
+
+  return output;
+}
+
+// Returns of a series at the target dates. In the exact mode dates without data get a zero return. In the asof mode
+// the value is carried forward and the return is calculated between consecutive target dates.
+
+inline auto aligned_returns(const TimeSeries& series, const QVector<qint64>& target, const JoinMode& mode)
+    -> QVector<double> {
+  if (mode == JoinMode::exact) {
+    return gather(series.return_perc, merge_join_index(target, series.dates), 0.0);
+  }
+
+  const auto index = asof_join_index(target, series.dates);
+
+  QVector<double> output(target.size(), 0.0);
+
+  for (int n = 1; n < target.size(); n++) {
+    if (index[n - 1] >= 0 && index[n] != index[n - 1]) {
+      const double last_value = series.values[index[n - 1]];
+
+      output[n] = 100 * (series.values[index[n]] - last_value) / last_value;
+    } else if (index[n - 1] < 0 && index[n] >= 0) {
+      output[n] = series.return_perc[index[n]];
+    }
+  }
+
+  return output;
+}
+
+#endif
@@ -0,0 +1,208 @@
+#include "analysis_funcs.hpp"
+#include <Eigen/Core>
+#include <Eigen/Eigenvalues>
+#include "math.hpp"
+
+auto compare_title(const CompareChart& chart) -> QString {
+  switch (chart) {
+    case CompareChart::return_perc:
+      return "Return";
+    case CompareChart::volatility:
+      return "Standard Deviation";
+    case CompareChart::accumulated_return:
+      return "Accumulated Return";
+    case CompareChart::accumulated_return_second_derivative:
+      return "Accumulated Return Second Derivative";
+  }
+
+  return "";
+}
+
+auto compare_unit(const CompareChart& chart) -> QString {
+  return (chart == CompareChart::accumulated_return_second_derivative) ? "" : "%";
+}
+
+auto compare_lines(const NamedSeries& inputs,
+                   const CompareChart& chart,
+                   const int& days,
+                   const int& window,
+                   const IsCancelled& is_cancelled) -> QVector<ChartLine> {
+  // We need at least 2 points to show a line chart and 3 to calculate the second derivative
+
+  const int min_points = (chart == CompareChart::accumulated_return_second_derivative) ? 3 : 2;
+
+  QVector<ChartLine> lines;
+
+  for (const auto& [name, series] : inputs) {
+    if (is_cancelled()) {
+      return {};
+    }
+
+    const auto start = series.tail_start(days);
+
+    const auto dates = series.dates.mid(start);
+    const auto vreturn = series.return_perc.mid(start);
+
+    if (dates.size() < min_points) {
+      continue;
+    }
+
+    switch (chart) {
+      case CompareChart::return_perc:
+        lines.append({name, dates, vreturn});
+        break;
+      case CompareChart::volatility:
+        lines.append({name, dates, rolling_standard_deviation(vreturn, window)});
+        break;
+      case CompareChart::accumulated_return:
+        lines.append({name, dates, accumulated_return(vreturn)});
+        break;
+      case CompareChart::accumulated_return_second_derivative:
+        lines.append({name, dates, second_derivative(accumulated_return(vreturn))});
+        break;
+    }
+  }
+
+  return lines;
+}
+
+auto correlation_lines(const NamedSeries& inputs,
+                       const QString& fund,
+                       const int& months,
+                       const int& window,
+                       const JoinMode& mode,
+                       const IsCancelled& is_cancelled) -> QVector<ChartLine> {
+  QVector<TimeSeries const*> series;
+
+  for (const auto& input : inputs) {
+    series.append(&input.second);
+  }
+
+  const auto dates = latest_dates(series, months);
+
+  if (dates.empty()) {
+    return {};
+  }
+
+  QVector<double> values(dates.size(), 0.0);
+
+  for (const auto& [name, s] : inputs) {
+    if (name == fund) {
+      values = aligned_returns(s, dates, mode);
+
+      break;
+    }
+  }
+
+  QVector<ChartLine> lines;
+
+  for (const auto& [name, s] : inputs) {
+    if (is_cancelled()) {
+      return {};
+    }
+
+    if (name != fund) {
+      const auto tvalues = aligned_returns(s, dates, mode);
+
+      lines.append({name, dates, rolling_correlation_coefficient(values, tvalues, window)});
+    }
+  }
+
+  return lines;
+}
+
+auto pca_projection(const NamedSeries& inputs, const int& months, const IsCancelled& is_cancelled) -> Projection {
+  if (inputs.size() < 2) {
+    return {};
+  }
+
+  QVector<TimeSeries const*> series;
+
+  for (const auto& input : inputs) {
+    series.append(&input.second);
+  }
+
+  const auto dates = latest_dates(series, months);
+
+  if (dates.size() < 2) {
+    return {};
+  }
+
+  // Each row holds the returns of one table aligned to the common dates
+
+  Eigen::MatrixXd data(inputs.size(), dates.size());
+
+  for (int k = 0; k < inputs.size(); k++) {
+    if (is_cancelled()) {
+      return {};
+    }
+
+    const auto returns = aligned_returns(*series[k], dates, JoinMode::exact);
+
+    data.row(k) = Eigen::Map<const Eigen::RowVectorXd>(returns.constData(), returns.size());
+  }
+
+  // Standardizing the data https://en.wikipedia.org/wiki/Feature_scaling#Standardization_(Z-score_Normalization)
+
+  data = data.rowwise() - data.colwise().mean();
+
+  Eigen::ArrayXd stddev = (data.array() * data.array()).colwise().sum().sqrt() / std::sqrt(data.rows() - 1);
+
+  for (int n = 0; n < data.cols(); n++) {
+    double std = stddev(n);
+    const double tol = 0.0001;
+
+    for (int m = 0; m < data.rows(); m++) {
+      if (std > tol) {
+        data(m, n) /= std;
+      }
+    }
+  }
+
+  // https://en.wikipedia.org/wiki/Sample_mean_and_covariance#Sample_covariance
+
+  Eigen::MatrixXd covariance =
+      (data.rowwise() - data.colwise().mean()).transpose() * (data.rowwise() - data.colwise().mean());
+
+  if (data.rows() > 1) {
+    covariance /= (data.rows() - 1);
+  }
+
+  if (is_cancelled()) {
+    return {};
+  }
+
+  // Finding eigenvalues and eigenvectors. We use SelfAdjointEigenSolver because the covariance matrix is symmetric.
+
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver;
+
+  solver.compute(covariance);
+
+  Eigen::VectorXd eigenvalues = solver.eigenvalues();
+  Eigen::MatrixXd eigenvectors = solver.eigenvectors();
+
+  // Calculating the explained variance
+
+  Projection projection;
+
+  double eigenvalues_sum = eigenvalues.sum();
+  Eigen::VectorXd percentage = 100 * eigenvalues / eigenvalues_sum;
+
+  projection.pc1_explained_variance = percentage[percentage.size() - 1];
+  projection.pc2_explained_variance = percentage[percentage.size() - 2];
+
+  // Projecting the data to the new space
+
+  Eigen::MatrixXd projection_matrix(eigenvectors.rows(), 2);
+
+  projection_matrix.col(0) = eigenvectors.col(eigenvectors.cols() - 1);
+  projection_matrix.col(1) = eigenvectors.col(eigenvectors.cols() - 2);
+
+  Eigen::MatrixXd pdata = data * projection_matrix;
+
+  for (int n = 0; n < pdata.rows(); n++) {
+    projection.points.append({inputs[n].first, QPointF(pdata(n, 0), pdata(n, 1))});
+  }
+
+  return projection;
+}
@@ -0,0 +1,56 @@
+#ifndef ANALYSIS_FUNCS_HPP
+#define ANALYSIS_FUNCS_HPP
+
+#include <QPair>
+#include <QPointF>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "alignment.hpp"
+#include "chart_binding.hpp"
+#include "time_series.hpp"
+
+// The calculations behind the analysis charts. They only read their arguments, so the widgets run them in the
+// global thread pool and the report mode runs them without any widget.
+
+using NamedSeries = QVector<QPair<QString, TimeSeries>>;
+
+// the calculation stops early and returns nothing when this returns true
+
+using IsCancelled = std::function<bool()>;
+
+enum class CompareChart { return_perc, volatility, accumulated_return, accumulated_return_second_derivative };
+
+auto compare_title(const CompareChart& chart) -> QString;
+
+auto compare_unit(const CompareChart& chart) -> QString;
+
+// one line per series with the last days rows of the selected chart
+
+auto compare_lines(const NamedSeries& inputs,
+                   const CompareChart& chart,
+                   const int& days,
+                   const int& window,
+                   const IsCancelled& is_cancelled) -> QVector<ChartLine>;
+
+// rolling correlation of every series with the fund
+
+auto correlation_lines(const NamedSeries& inputs,
+                       const QString& fund,
+                       const int& months,
+                       const int& window,
+                       const JoinMode& mode,
+                       const IsCancelled& is_cancelled) -> QVector<ChartLine>;
+
+// position of every series on the first two principal components
+
+struct Projection {
+  QVector<QPair<QString, QPointF>> points;
+
+  double pc1_explained_variance = 0.0;
+  double pc2_explained_variance = 0.0;
+};
+
+auto pca_projection(const NamedSeries& inputs, const int& months, const IsCancelled& is_cancelled) -> Projection;
+
+#endif
@@ -0,0 +1,266 @@
+#include "archive_funcs.hpp"
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <vector>
+#include "binary_funcs.hpp"
+
+namespace {
+
+constexpr quint32 magic = 0x584b5453;  // "STKX" when read in the byte order it was written
+
+// increased every time the layout of the file changes
+
+constexpr quint32 format_version = 2;
+
+// the first version had the dates in seconds since epoch
+
+constexpr quint32 seconds_format_version = 1;
+
+constexpr qint64 header_size = 4 * sizeof(quint32);
+
+constexpr qint64 chunk_header_size = 2 * sizeof(quint32);
+
+// dates, values, return_perc and accumulated_return_perc. All of them 8 bytes wide.
+
+constexpr qint64 row_size = 4 * sizeof(qint64);
+
+struct Chunk {
+  std::vector<qint64> dates;
+  std::vector<double> values;
+  std::vector<double> return_perc;
+  std::vector<double> accumulated_return_perc;
+
+  [[nodiscard]] auto size() const -> qint64 { return qint64(dates.size()); }
+
+  void clear() {
+    dates.clear();
+    values.clear();
+    return_perc.clear();
+    accumulated_return_perc.clear();
+  }
+};
+
+auto write_chunk(QIODevice& out, const Chunk& chunk) -> bool {
+  return write_value(out, quint32(chunk.size())) && write_value(out, quint32(0)) &&
+         write_array(out, chunk.dates.data(), chunk.size()) && write_array(out, chunk.values.data(), chunk.size()) &&
+         write_array(out, chunk.return_perc.data(), chunk.size()) &&
+         write_array(out, chunk.accumulated_return_perc.data(), chunk.size());
+}
+
+auto export_table(const QSqlDatabase& db, const int& instrument_id, const QString& name, QIODevice& out) -> bool {
+  auto query = QSqlQuery(db);
+
+  query.setForwardOnly(true);
+
+  if (instrument_id < 0) {
+    query.prepare("select date, value, return_perc, accumulated_return_perc from " + name + " order by date, id");
+  } else {
+    query.prepare(
+        "select date, value, return_perc, accumulated_return_perc from prices where instrument_id = ? order by date");
+
+    query.addBindValue(instrument_id);
+  }
+
+  if (!query.exec()) {
+    qDebug() << "failed to export table " + name.toUtf8() + ": " + query.lastError().text().toUtf8();
+
+    return false;
+  }
+
+  if (!write_name(out, name)) {
+    return false;
+  }
+
+  Chunk chunk;
+
+  chunk.dates.reserve(archive_chunk_rows);
+  chunk.values.reserve(archive_chunk_rows);
+  chunk.return_perc.reserve(archive_chunk_rows);
+  chunk.accumulated_return_perc.reserve(archive_chunk_rows);
+
+  while (query.next()) {
+    chunk.dates.push_back(query.value(0).toLongLong());
+    chunk.values.push_back(query.value(1).toDouble());
+    chunk.return_perc.push_back(query.value(2).toDouble());
+    chunk.accumulated_return_perc.push_back(query.value(3).toDouble());
+
+    if (chunk.size() == archive_chunk_rows) {
+      if (!write_chunk(out, chunk)) {
+        return false;
+      }
+
+      chunk.clear();
+    }
+  }
+
+  // the last chunk may be empty and then it is also the end of the table
+
+  if (chunk.size() > 0 && !write_chunk(out, chunk)) {
+    return false;
+  }
+
+  chunk.clear();
+
+  return write_chunk(out, chunk);
+}
+
+}  // namespace
+
+auto export_tables(const QSqlDatabase& db, const QVector<QPair<int, QString>>& tables, const QString& path) -> bool {
+  QSaveFile out(path);
+
+  if (!out.open(QIODevice::WriteOnly)) {
+    qDebug() << "failed to write " + path.toUtf8() + ": " + out.errorString().toUtf8();
+
+    return false;
+  }
+
+  bool ok = write_value(out, magic) && write_value(out, format_version) && write_value(out, quint32(tables.size())) &&
+            write_value(out, quint32(0));
+
+  for (auto& [id, name] : tables) {
+    if (!ok) {
+      break;
+    }
+
+    ok = export_table(db, id, name, out);
+  }
+
+  if (!ok) {
+    qDebug() << "failed to export the tables to " + path.toUtf8() + ": " + out.errorString().toUtf8();
+
+    out.cancelWriting();
+
+    return false;
+  }
+
+  return out.commit();
+}
+
+auto read_archive(const QString& path, const std::function<void(const QString&, TimeSeries&)>& callback) -> bool {
+  QFile file(path);
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    qDebug() << "failed to open " + path.toUtf8() + ": " + file.errorString().toUtf8();
+
+    return false;
+  }
+
+  const qint64 size = file.size();
+
+  const uchar* data = (size >= header_size) ? file.map(0, size) : nullptr;
+
+  if (data == nullptr) {
+    qDebug() << path.toUtf8() + " is not a valid archive";
+
+    return false;
+  }
+
+  const uchar* p = data;
+  const uchar* end = data + size;
+
+  quint32 header[4];
+
+  read_array(p, header, 4);
+
+  if (header[0] != magic || (header[1] != format_version && header[1] != seconds_format_version)) {
+    qDebug() << path.toUtf8() + " was written by an unknown version";
+
+    return false;
+  }
+
+  for (quint32 n = 0; n < header[2]; n++) {
+    quint32 name_size = 0;
+
+    if (end - p < chunk_header_size) {
+      qDebug() << path.toUtf8() + " is truncated";
+
+      return false;
+    }
+
+    read_value(p, name_size);
+
+    p += sizeof(quint32);
+
+    if (end - p < padded(name_size)) {
+      qDebug() << path.toUtf8() + " is truncated";
+
+      return false;
+    }
+
+    const auto name = QString::fromUtf8(reinterpret_cast<const char*>(p), int(name_size));
+
+    p += padded(name_size);
+
+    // The chunk headers are walked first so that each column is allocated only once
+
+    QVector<const uchar*> chunks;
+    QVector<quint32> chunk_rows;
+
+    qint64 rows = 0;
+
+    for (const uchar* c = p;;) {
+      quint32 count = 0;
+
+      if (end - c < chunk_header_size) {
+        qDebug() << path.toUtf8() + " is truncated";
+
+        return false;
+      }
+
+      read_value(c, count);
+
+      c += sizeof(quint32);
+
+      if (count == 0) {
+        p = c;
+
+        break;
+      }
+
+      if ((end - c) / row_size < count) {
+        qDebug() << path.toUtf8() + " is truncated";
+
+        return false;
+      }
+
+      chunks.append(c);
+      chunk_rows.append(count);
+
+      rows += count;
+
+      c += row_size * count;
+    }
+
+    TimeSeries series;
+
+    series.resize(int(rows));
+
+    qint64 offset = 0;
+
+    for (int k = 0; k < chunks.size(); k++) {
+      const uchar* c = chunks[k];
+      const qint64 count = chunk_rows[k];
+
+      read_array(c, series.dates.data() + offset, count);
+      read_array(c, series.values.data() + offset, count);
+      read_array(c, series.return_perc.data() + offset, count);
+      read_array(c, series.accumulated_return_perc.data() + offset, count);
+
+      offset += count;
+    }
+
+    if (header[1] == seconds_format_version) {
+      for (auto& date : series.dates) {
+        date *= 1000;
+      }
+    }
+
+    callback(name, series);
+  }
+
+  return true;
+}
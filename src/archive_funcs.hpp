@@ -0,0 +1,26 @@
+#ifndef ARCHIVE_FUNCS_HPP
+#define ARCHIVE_FUNCS_HPP
+
+#include <QPair>
+#include <QSqlDatabase>
+#include <functional>
+#include "time_series.hpp"
+
+// Columnar archive used to move tables between databases. A header with the magic and the format version is followed
+// by the tables. Each table has its name and then chunks of at most archive_chunk_rows rows. A chunk holds its row
+// count and the dates, values, return_perc and accumulated_return_perc columns one after the other. A chunk with no
+// rows ends the table.
+
+constexpr int archive_chunk_rows = 65536;
+
+// The rows are streamed from the database one chunk at a time so memory use does not depend on the table sizes.
+// Negative instrument ids are per stock tables.
+
+auto export_tables(const QSqlDatabase& db, const QVector<QPair<int, QString>>& tables, const QString& path) -> bool;
+
+// The file is memory mapped and the columns of each table are copied straight into its series before it is handed to
+// the callback. The series ids are not stored in the archive and are left at zero.
+
+auto read_archive(const QString& path, const std::function<void(const QString&, TimeSeries&)>& callback) -> bool;
+
+#endif
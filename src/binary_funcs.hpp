@@ -0,0 +1,54 @@
+#ifndef BINARY_FUNCS_HPP
+#define BINARY_FUNCS_HPP
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+#include <cstring>
+
+// Helpers shared by the binary files we write. Values are written in the native byte order and every block is padded
+// to 8 bytes so that the columns of a memory mapped file are aligned.
+
+inline auto padded(const qint64& size) -> qint64 {
+  return (size + 7) & ~qint64(7);
+}
+
+template <typename T>
+auto write_value(QIODevice& out, const T& value) -> bool {
+  return out.write(reinterpret_cast<const char*>(&value), sizeof(T)) == sizeof(T);
+}
+
+template <typename T>
+auto write_array(QIODevice& out, const T* data, const qint64& count) -> bool {
+  const qint64 size = count * sizeof(T);
+
+  return out.write(reinterpret_cast<const char*>(data), size) == size;
+}
+
+// the size as a quint32 followed by 4 bytes of padding and then the utf8 bytes padded to 8
+
+inline auto write_name(QIODevice& out, const QString& name) -> bool {
+  const auto utf8 = name.toUtf8();
+
+  return write_value(out, quint32(utf8.size())) && write_value(out, quint32(0)) &&
+         out.write(utf8 + QByteArray(int(padded(utf8.size()) - utf8.size()), '\0')) == padded(utf8.size());
+}
+
+template <typename T>
+void read_value(const uchar*& src, T& value) {
+  std::memcpy(&value, src, sizeof(T));
+
+  src += sizeof(T);
+}
+
+// the column has to be resized before it is filled in parts
+
+template <typename T>
+void read_array(const uchar*& src, T* data, const qint64& count) {
+  std::memcpy(data, src, count * sizeof(T));
+
+  src += count * sizeof(T);
+}
+
+#endif
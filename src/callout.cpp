@@ -7,7 +7,7 @@
 Callout::Callout(QChart* parent) : QGraphicsItem(parent), chart(parent) {}
 
 auto Callout::boundingRect() const -> QRectF {
-  const QPointF a = mapFromParent(chart->mapToPosition(anchor));
+  const QPointF& a = anchor_position;
   QRectF r;
 
   r.setLeft(qMin(rect.left(), a.x()));
@@ -22,11 +22,17 @@ void Callout::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, Q
   Q_UNUSED(option)
   Q_UNUSED(widget)
 
-  QPainterPath path;
+  painter->setBrush(QColor(255, 255, 255));
+  painter->drawPath(path);
+  painter->drawText(textRect, text);
+}
+
+void Callout::update_path() {
+  path = QPainterPath();
 
   path.addRoundedRect(rect, 5, 5);
 
-  const QPointF a = mapFromParent(chart->mapToPosition(anchor));
+  const QPointF& a = anchor_position;
 
   if (!rect.contains(a)) {
     QPointF point1;
@@ -80,10 +86,6 @@ void Callout::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, Q
 
     path = path.simplified();
   }
-
-  painter->setBrush(QColor(255, 255, 255));
-  painter->drawPath(path);
-  painter->drawText(textRect, text);
 }
 
 void Callout::setText(const QString& value) {
@@ -109,4 +111,8 @@ void Callout::updateGeometry() {
   prepareGeometryChange();
 
   setPos(chart->mapToPosition(anchor) + QPoint(-80, -100));
+
+  anchor_position = mapFromParent(chart->mapToPosition(anchor));
+
+  update_path();
 }
@@ -14,6 +14,9 @@ class Callout : public QGraphicsItem {
 
   void setText(const QString& value);
   void setAnchor(QPointF point);
+
+  // must follow setText() and setAnchor(). The shape is built here and paint() only draws it.
+
   void updateGeometry();
 
   [[nodiscard]] auto boundingRect() const -> QRectF override;
@@ -23,9 +26,13 @@ class Callout : public QGraphicsItem {
   QChart* const chart;
 
   QPointF anchor;
+  QPointF anchor_position;  // the anchor in item coordinates
+  QPainterPath path;
   QRectF rect;
   QString text;
   QRectF textRect;
+
+  void update_path();
 };
 
 #endif
\ No newline at end of file
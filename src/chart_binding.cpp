@@ -0,0 +1,129 @@
+#include "chart_binding.hpp"
+#include <algorithm>
+#include "chart_funcs.hpp"
+#include "series_pyramid.hpp"
+
+ChartBinding::ChartBinding(QChart* chart) : chart(chart) {}
+
+void ChartBinding::begin() {
+  used.clear();
+
+  has_data = false;
+}
+
+void ChartBinding::set_line(const QString& key, const QVector<qint64>& dates, const QVector<double>& values) {
+  if (dates.empty()) {
+    return;
+  }
+
+  const auto [y0, y1] = std::minmax_element(values.constBegin(), values.constEnd());
+
+  extend(double(dates.first()), double(dates.last()), *y0, *y1);
+
+  chart_index.set_line(key, key.toLower(), dates, values);
+
+  if (auto it = series.constFind(key); it != series.constEnd()) {
+    used.insert(key);
+
+    if (auto pyramid = SeriesPyramid::find(it.value()); pyramid != nullptr) {
+      pyramid->set_data(dates, values);
+    }
+
+    return;
+  }
+
+  auto line = new QLineSeries();
+
+  line->setName(key.toLower());
+
+  attach(key, line);
+
+  new SeriesPyramid(chart, line, dates, values);
+}
+
+void ChartBinding::set_point(const QString& key, const double& x, const double& y) {
+  extend(x, x, y, y);
+
+  chart_index.set_point(key, QPointF(x, y));
+
+  if (auto it = series.constFind(key); it != series.constEnd()) {
+    used.insert(key);
+
+    it.value()->replace({QPointF(x, y)});
+
+    return;
+  }
+
+  auto scatter = new QScatterSeries();
+
+  scatter->setName(key);
+  scatter->append(x, y);
+
+  attach(key, scatter);
+}
+
+void ChartBinding::end() {
+  for (auto it = series.begin(); it != series.end();) {
+    if (used.contains(it.key())) {
+      ++it;
+
+      continue;
+    }
+
+    chart->removeSeries(it.value());
+
+    delete it.value();
+
+    chart_index.remove(it.key());
+
+    it = series.erase(it);
+  }
+
+  chart_index.build();
+
+  if (!has_data) {
+    return;
+  }
+
+  chart->axes(Qt::Vertical)[0]->setRange(ymin - 0.05 * fabs(ymin), ymax + 0.05 * fabs(ymax));
+
+  if (dynamic_cast<QDateTimeAxis*>(chart->axes(Qt::Horizontal)[0]) != nullptr) {
+    fit_date_axis(chart, qint64(xmin), qint64(xmax));
+  } else {
+    chart->axes(Qt::Horizontal)[0]->setRange(xmin - 0.05 * fabs(xmin), xmax + 0.05 * fabs(xmax));
+  }
+}
+
+void ChartBinding::clear() {
+  chart->removeAllSeries();
+
+  series.clear();
+  used.clear();
+
+  chart_index.clear();
+
+  has_data = false;
+}
+
+auto ChartBinding::index() const -> const ChartIndex* {
+  return &chart_index;
+}
+
+void ChartBinding::attach(const QString& key, QXYSeries* s) {
+  chart->addSeries(s);
+
+  s->attachAxis(chart->axes(Qt::Horizontal)[0]);
+  s->attachAxis(chart->axes(Qt::Vertical)[0]);
+
+  series.insert(key, s);
+  used.insert(key);
+}
+
+void ChartBinding::extend(const double& x0, const double& x1, const double& y0, const double& y1) {
+  xmin = has_data ? std::min(xmin, x0) : x0;
+  xmax = has_data ? std::max(xmax, x1) : x1;
+  ymin = has_data ? std::min(ymin, y0) : y0;
+  ymax = has_data ? std::max(ymax, y1) : y1;
+
+  has_data = true;
+}
@@ -0,0 +1,67 @@
+#ifndef CHART_BINDING_HPP
+#define CHART_BINDING_HPP
+
+#include <QHash>
+#include <QSet>
+#include <QtCharts>
+#include "chart_index.hpp"
+
+// Keeps the series of a chart between updates. Every update is written between begin() and end(). The series are
+// found by key and only their points change. Series are created the first time their key is set, and end() removes
+// the ones whose key was not set since begin(). end() also fits the axes to the data.
+//
+// The axes must already be in the chart. They are never recreated. The index follows the data set here and is what the
+// hover lookups use.
+
+// line calculated away from the gui thread and handed to set_line() once it is ready
+
+struct ChartLine {
+  QString key;
+
+  QVector<qint64> dates;
+  QVector<double> values;
+};
+
+class ChartBinding {
+ public:
+  explicit ChartBinding(QChart* chart);
+
+  void begin();
+
+  // Line series with a date axis. The series is named after the key in lower case, so the legend and the callouts
+  // show the table names the way the rest of the charts do.
+
+  void set_line(const QString& key, const QVector<qint64>& dates, const QVector<double>& values);
+
+  // scatter series with a single point named after the key
+
+  void set_point(const QString& key, const double& x, const double& y);
+
+  void end();
+
+  void clear();
+
+  [[nodiscard]] auto index() const -> const ChartIndex*;
+
+ private:
+  QChart* const chart;
+
+  ChartIndex chart_index;
+
+  QHash<QString, QXYSeries*> series;
+
+  QSet<QString> used;
+
+  bool has_data = false;
+
+  double xmin = 0.0;
+  double xmax = 0.0;
+  double ymin = 0.0;
+  double ymax = 0.0;
+
+  void attach(const QString& key, QXYSeries* s);
+
+  void extend(const double& x0, const double& x1, const double& y0, const double& y1);
+};
+
+#endif
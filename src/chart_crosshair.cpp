@@ -0,0 +1,171 @@
+#include "chart_crosshair.hpp"
+#include <QMouseEvent>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "csv_funcs.hpp"
+
+namespace {
+
+// lines beyond this number are left out of the callout, starting with the ones farthest from the mouse
+
+constexpr int max_callout_rows = 20;
+
+// scatter points farther than this from the mouse are not shown
+
+constexpr double max_point_distance = 20.0;
+
+}  // namespace
+
+ChartCrosshair::ChartCrosshair(QChart* chart, const ChartIndex* index, FormatValue format_value)
+    : chart(chart),
+      index(index),
+      format_value(std::move(format_value)),
+      callout(new Callout(chart)),
+      line(new QGraphicsLineItem(chart)) {
+  if (!this->format_value) {
+    this->format_value = [](const double& value) { return QString::number(value, 'f', 2); };
+  }
+
+  line->setPen(QPen(QColor(128, 128, 128), 1.0, Qt::DashLine));
+  line->setZValue(10);
+
+  hide();
+
+  // the callout anchor is kept in pixels, so it is wrong after a resize until the mouse moves
+
+  connect(chart, &QChart::plotAreaChanged, this, &ChartCrosshair::hide);
+}
+
+void ChartCrosshair::watch(QChartView* view) {
+  this->view = view;
+
+  view->viewport()->setMouseTracking(true);
+  view->viewport()->installEventFilter(this);
+}
+
+void ChartCrosshair::hide() {
+  callout->hide();
+  line->hide();
+}
+
+auto ChartCrosshair::eventFilter(QObject* object, QEvent* event) -> bool {
+  if (view == nullptr || object != view->viewport()) {
+    return false;
+  }
+
+  if (event->type() == QEvent::MouseMove) {
+    const auto mouse_event = static_cast<QMouseEvent*>(event);
+
+    move_to(chart->mapFromScene(view->mapToScene(mouse_event->pos())));
+  } else if (event->type() == QEvent::Leave) {
+    hide();
+  }
+
+  // the view still gets the event for the rubber band zoom
+
+  return false;
+}
+
+void ChartCrosshair::move_to(const QPointF& position) {
+  if (chart->series().empty() || !chart->plotArea().contains(position)) {
+    hide();
+
+    return;
+  }
+
+  const auto value = chart->mapToValue(position);
+
+  if (index->has_lines()) {
+    show_lines(value);
+  } else {
+    show_point(position, value);
+  }
+}
+
+void ChartCrosshair::show_lines(const QPointF& value) {
+  auto hits = index->lines_at(qint64(value.x()));
+
+  if (hits.empty()) {
+    hide();
+
+    return;
+  }
+
+  const auto distance = [&](const ChartIndex::Hit& hit) { return std::fabs(hit.point.y() - value.y()); };
+
+  const auto closer = [&](const ChartIndex::Hit& a, const ChartIndex::Hit& b) { return distance(a) < distance(b); };
+
+  const int hidden = std::max(hits.size() - max_callout_rows, 0);
+
+  if (hidden > 0) {
+    std::nth_element(hits.begin(), hits.begin() + max_callout_rows, hits.end(), closer);
+
+    hits.resize(max_callout_rows);
+  }
+
+  // The crosshair stays on the date the values were read at. The callout points at the line nearest to the mouse.
+
+  const auto nearest = *std::min_element(hits.constBegin(), hits.constEnd(), closer);
+
+  const QPointF anchor(value.x(), nearest.point.y());
+
+  std::sort(hits.begin(), hits.end(),
+            [](const ChartIndex::Hit& a, const ChartIndex::Hit& b) { return a.point.y() > b.point.y(); });
+
+  QStringList rows = {format_date(qint64(value.x()))};
+
+  for (const auto& hit : hits) {
+    rows.append(QString("%1: %2").arg(hit.name, format_value(hit.point.y())));
+  }
+
+  if (hidden > 0) {
+    rows.append(QString("%1 more").arg(hidden));
+  }
+
+  const auto area = chart->plotArea();
+
+  const auto x = chart->mapToPosition(anchor).x();
+
+  line->setLine(x, area.top(), x, area.bottom());
+  line->show();
+
+  show_callout(rows.join("\n"), anchor);
+}
+
+void ChartCrosshair::show_point(const QPointF& position, const QPointF& value) {
+  // pixels per unit of each axis, so the nearest point is the one nearest on the screen
+
+  const auto area = chart->plotArea();
+
+  const auto top_left = chart->mapToValue(area.topLeft());
+  const auto bottom_right = chart->mapToValue(area.bottomRight());
+
+  const double xscale = area.width() / std::max(std::fabs(bottom_right.x() - top_left.x()), 1e-12);
+  const double yscale = area.height() / std::max(std::fabs(top_left.y() - bottom_right.y()), 1e-12);
+
+  ChartIndex::Hit hit;
+
+  if (!index->nearest_point(value, xscale, yscale, hit) ||
+      QLineF(chart->mapToPosition(hit.point), position).length() > max_point_distance) {
+    hide();
+
+    return;
+  }
+
+  line->hide();
+
+  show_callout(QString("Fund: %1").arg(hit.name), hit.point);
+}
+
+void ChartCrosshair::show_callout(const QString& text, const QPointF& anchor) {
+  callout->setText(text);
+
+  callout->setAnchor(anchor);
+
+  callout->setZValue(11);
+
+  callout->updateGeometry();
+
+  callout->show();
+}
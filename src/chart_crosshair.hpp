@@ -0,0 +1,56 @@
+#ifndef CHART_CROSSHAIR_HPP
+#define CHART_CROSSHAIR_HPP
+
+#include <QObject>
+#include <QtCharts>
+#include <functional>
+#include "callout.hpp"
+#include "chart_index.hpp"
+
+// Hover information of a chart. It follows the mouse over the plot area and asks the index for the points under it
+// once per move, which does not depend on the series having hover events or on how many of them there are.
+//
+// Charts with lines get a vertical line at the date under the mouse and a callout with the last value of every line
+// on or before that date. Charts with scatter points get a callout naming the point nearest to the mouse.
+
+class ChartCrosshair : public QObject {
+  Q_OBJECT
+ public:
+  using FormatValue = std::function<QString(const double& value)>;
+
+  ChartCrosshair(QChart* chart, const ChartIndex* index, FormatValue format_value = {});
+
+  // the view whose mouse moves are followed
+
+  void watch(QChartView* view);
+
+  void hide();
+
+ protected:
+  auto eventFilter(QObject* object, QEvent* event) -> bool override;
+
+ private:
+  QChart* const chart;
+
+  const ChartIndex* const index;
+
+  FormatValue format_value;
+
+  QChartView* view = nullptr;
+
+  Callout* const callout;
+
+  QGraphicsLineItem* const line;
+
+  // position in chart coordinates
+
+  void move_to(const QPointF& position);
+
+  void show_lines(const QPointF& value);
+
+  void show_point(const QPointF& position, const QPointF& value);
+
+  void show_callout(const QString& text, const QPointF& anchor);
+};
+
+#endif
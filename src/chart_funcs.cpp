@@ -1,13 +1,26 @@
 #include "chart_funcs.hpp"
-#include <QSqlError>
-#include <QSqlQuery>
+#include <algorithm>
+#include <cmath>
+#include "alignment.hpp"
+#include "csv_funcs.hpp"
 
-void clear_chart(QChart* chart) {
-  chart->removeAllSeries();
+namespace {
 
-  for (auto& axis : chart->axes()) {
-    chart->removeAxis(axis);
-  }
+// charts spanning fewer days than this show the time in the date axis
+
+constexpr qint64 intraday_axis_span = 7LL * 86400 * 1000;
+
+// points drawn when the chart was not laid out yet and its plot area is still empty. Afterwards it is one per pixel.
+
+constexpr int min_chart_resolution = 1024;
+
+}  // namespace
+
+void fit_date_axis(QChart* chart, const qint64& xmin, const qint64& xmax) {
+  auto axis = dynamic_cast<QDateTimeAxis*>(chart->axes(Qt::Horizontal)[0]);
+
+  axis->setFormat((xmax - xmin < intraday_axis_span) ? "dd/MM/yyyy hh:mm" : "dd/MM/yyyy");
+  axis->setRange(QDateTime::fromMSecsSinceEpoch(xmin), QDateTime::fromMSecsSinceEpoch(xmax));
 }
 
 void add_axes_to_chart(QChart* chart, const QString& ytitle) {
@@ -30,110 +43,96 @@ void add_axes_to_chart(QChart* chart, const QString& ytitle) {
   chart->addAxis(axis_y, Qt::AlignLeft);
 }
 
-auto add_series_to_chart(QChart* chart, const Model* tmodel, const QString& series_name, const QString& column_name)
-    -> QLineSeries* {
-  const auto series = new QLineSeries();
-
-  series->setName(series_name.toLower());
-
-  double ymin = dynamic_cast<QValueAxis*>(chart->axes(Qt::Vertical)[0])->min();
-  double ymax = dynamic_cast<QValueAxis*>(chart->axes(Qt::Vertical)[0])->max();
-  qint64 xmin = dynamic_cast<QDateTimeAxis*>(chart->axes(Qt::Horizontal)[0])->min().toMSecsSinceEpoch();
-  qint64 xmax = dynamic_cast<QDateTimeAxis*>(chart->axes(Qt::Horizontal)[0])->max().toMSecsSinceEpoch();
-
-  for (int n = 0; n < tmodel->rowCount(); n++) {
-    const auto qdt = QDateTime::fromString(tmodel->record(n).value("date").toString(), "dd/MM/yyyy");
-
-    const auto epoch_in_ms = qdt.toMSecsSinceEpoch();
-
-    const double v = tmodel->record(n).value(column_name).toDouble();
-
-    if (!chart->series().empty()) {
-      ymin = std::min(ymin, v);
-      ymax = std::max(ymax, v);
-      xmin = std::min(xmin, epoch_in_ms);
-      xmax = std::max(xmax, epoch_in_ms);
-    } else {
-      if (n == 0) {
-        ymin = v;
-        ymax = v;
-        xmin = epoch_in_ms;
-        xmax = epoch_in_ms;
-      } else {
-        ymin = std::min(ymin, v);
-        ymax = std::max(ymax, v);
-        xmin = std::min(xmin, epoch_in_ms);
-        xmax = std::max(xmax, epoch_in_ms);
-      }
-    }
+auto chart_resolution(const QChart* chart) -> int {
+  const int width = int(chart->plotArea().width());
 
-    series->append(epoch_in_ms, v);
+  if (width <= 0) {
+    return min_chart_resolution;
   }
 
-  chart->addSeries(series);
+  // downsample_lttb() needs at least three points to keep anything but the whole series
 
-  series->attachAxis(chart->axes(Qt::Horizontal)[0]);
-  series->attachAxis(chart->axes(Qt::Vertical)[0]);
+  return std::max(width, 3);
+}
 
-  chart->axes(Qt::Vertical)[0]->setRange(ymin - 0.05 * fabs(ymin), ymax + 0.05 * fabs(ymax));
-  chart->axes(Qt::Horizontal)[0]->setRange(QDateTime::fromMSecsSinceEpoch(xmin), QDateTime::fromMSecsSinceEpoch(xmax));
+auto downsample_lttb(const QVector<qint64>& dates, const QVector<double>& values, const int& threshold)
+    -> QVector<QPointF> {
+  const int size = dates.size();
 
-  return series;
-}
+  if (threshold < 3 || size <= threshold) {
+    QVector<QPointF> points(size);
 
-auto add_series_to_chart(QChart* chart,
-                         const QVector<int>& dates,
-                         const QVector<double>& values,
-                         const QString& series_name) -> QLineSeries* {
-  const auto series = new QLineSeries();
-
-  series->setName(series_name.toLower());
-
-  double ymin = dynamic_cast<QValueAxis*>(chart->axes(Qt::Vertical)[0])->min();
-  double ymax = dynamic_cast<QValueAxis*>(chart->axes(Qt::Vertical)[0])->max();
-  qint64 xmin = dynamic_cast<QDateTimeAxis*>(chart->axes(Qt::Horizontal)[0])->min().toMSecsSinceEpoch();
-  qint64 xmax = dynamic_cast<QDateTimeAxis*>(chart->axes(Qt::Horizontal)[0])->max().toMSecsSinceEpoch();
-
-  for (int n = 0; n < dates.size(); n++) {
-    const double v = values[n];
-    const qint64 d = static_cast<qint64>(dates[n]) * 1000;
-
-    if (!chart->series().empty()) {
-      ymin = std::min(ymin, v);
-      ymax = std::max(ymax, v);
-      xmin = std::min(xmin, d);
-      xmax = std::max(xmax, d);
-    } else {
-      if (n == 0) {
-        ymin = v;
-        ymax = v;
-        xmin = d;
-        xmax = d;
-      } else {
-        ymin = std::min(ymin, v);
-        ymax = std::max(ymax, v);
-        xmin = std::min(xmin, d);
-        xmax = std::max(xmax, d);
-      }
+    for (int n = 0; n < size; n++) {
+      points[n] = QPointF(dates[n], values[n]);
     }
 
-    series->append(d, v);
+    return points;
   }
 
-  chart->addSeries(series);
+  // https://skemman.is/handle/1946/15343 The first and the last points are kept. The others are split in
+  // threshold - 2 buckets and each bucket keeps the point making the largest triangle with the point kept in the
+  // previous bucket and the average of the next one.
+
+  QVector<QPointF> points;
 
-  series->attachAxis(chart->axes(Qt::Horizontal)[0]);
-  series->attachAxis(chart->axes(Qt::Vertical)[0]);
+  points.reserve(threshold);
 
-  chart->axes(Qt::Vertical)[0]->setRange(ymin - 0.05 * fabs(ymin), ymax + 0.05 * fabs(ymax));
-  chart->axes(Qt::Horizontal)[0]->setRange(QDateTime::fromMSecsSinceEpoch(xmin), QDateTime::fromMSecsSinceEpoch(xmax));
+  points.append(QPointF(dates[0], values[0]));
 
-  return series;
+  const double bucket_size = double(size - 2) / (threshold - 2);
+
+  int a = 0;
+
+  for (int k = 0; k < threshold - 2; k++) {
+    const int begin = int(k * bucket_size) + 1;
+    const int end = (k == threshold - 3) ? size - 1 : int((k + 1) * bucket_size) + 1;
+
+    const int next_begin = end;
+    const int next_end = std::min(int((k + 2) * bucket_size) + 1, size);
+
+    // x is taken relative to the first point so the products keep their precision with millisecond dates
+
+    double avg_x = 0.0;
+    double avg_y = 0.0;
+
+    for (int n = next_begin; n < next_end; n++) {
+      avg_x += double(dates[n] - dates[0]);
+      avg_y += values[n];
+    }
+
+    avg_x /= std::max(next_end - next_begin, 1);
+    avg_y /= std::max(next_end - next_begin, 1);
+
+    const double ax = double(dates[a] - dates[0]);
+    const double ay = values[a];
+
+    double max_area = -1.0;
+    int chosen = begin;
+
+    for (int n = begin; n < end; n++) {
+      const double x = double(dates[n] - dates[0]);
+
+      const double area = std::fabs((ax - avg_x) * (values[n] - ay) - (ax - x) * (avg_y - ay));
+
+      if (area > max_area) {
+        max_area = area;
+        chosen = n;
+      }
+    }
+
+    points.append(QPointF(dates[chosen], values[chosen]));
+
+    a = chosen;
+  }
+
+  points.append(QPointF(dates[size - 1], values[size - 1]));
+
+  return points;
 }
 
 auto add_tables_barseries_to_chart(QChart* chart,
-                                   const QVector<Table const*>& tables,
-                                   const QVector<int>& list_dates,
+                                   const QVector<Instrument const*>& tables,
+                                   const QVector<qint64>& list_dates,
                                    const QString& series_name,
                                    const QString& column_name)
     -> std::tuple<QStackedBarSeries*, QVector<QBarSet*>, QStringList> {
@@ -146,30 +145,14 @@ auto add_tables_barseries_to_chart(QChart* chart,
   QStringList categories;
 
   for (auto& date : list_dates) {
-    const auto qdt = QDateTime::fromSecsSinceEpoch(date);
-
-    const QString date_month = qdt.toString("dd/MM/yyyy");
-
-    categories.append(date_month);
-
-    for (int m = 0; m < tables.size(); m++) {
-      bool has_date = false;
-
-      for (int n = tables[m]->model->rowCount() - 1; n >= 0; n--) {
-        const QString tdate = tables[m]->model->record(n).value("date").toString();
-
-        if (date_month == tdate) {
-          barsets[m]->append(tables[m]->model->record(n).value(column_name).toDouble());
+    categories.append(format_date(date));
+  }
 
-          has_date = true;
+  for (int m = 0; m < tables.size(); m++) {
+    const auto& series = tables[m]->series;
 
-          break;
-        }
-      }
-
-      if (!has_date) {
-        barsets[m]->append(0.0);
-      }
+    for (auto& value : gather(series.column(column_name), merge_join_index(list_dates, series.dates), 0.0)) {
+      barsets[m]->append(value);
     }
   }
 
@@ -207,36 +190,3 @@ auto add_tables_barseries_to_chart(QChart* chart,
 
   return {series, barsets, categories};
 }
-
-auto get_unique_months_from_db(const QSqlDatabase& db, const QVector<Table const*>& tables, const int& last_n_months)
-    -> QVector<int> {
-  QSet<int> set;
-
-  for (auto& table : tables) {
-    if (set.size() == last_n_months) {
-      break;
-    }
-
-    // making sure all the latest data was saved to the database
-
-    table->model->submitAll();
-
-    auto query = QSqlQuery(db);
-
-    query.prepare("select distinct date from " + table->name + " order by date desc");
-
-    if (query.exec()) {
-      while (query.next() && set.size() < last_n_months) {
-        set.insert(query.value(0).toInt());
-      }
-    } else {
-      qDebug() << table->model->lastError().text().toUtf8();
-    }
-  }
-
-  QVector<int> list = QVector<int>::fromList(set.values());
-
-  std::sort(list.begin(), list.end());
-
-  return list;
-}
\ No newline at end of file
@@ -3,29 +3,29 @@
 
 #include <QtCharts>
 #include <tuple>
-#include "model.hpp"
-#include "table.hpp"
-
-void clear_chart(QChart* chart);
+#include "instrument.hpp"
 
 void add_axes_to_chart(QChart* chart, const QString& ytitle);
 
-auto add_series_to_chart(QChart* chart, const Model* tmodel, const QString& series_name, const QString& column_name)
-    -> QLineSeries*;
+// Sets the range of the date axis. The time is shown in the labels when the range is shorter than a week.
+
+void fit_date_axis(QChart* chart, const qint64& xmin, const qint64& xmax);
+
+// number of points worth drawing in a line series. About one per pixel of the plot area.
 
-auto add_series_to_chart(QChart* chart,
-                         const QVector<int>& dates,
-                         const QVector<double>& values,
-                         const QString& series_name) -> QLineSeries*;
+auto chart_resolution(const QChart* chart) -> int;
+
+// Largest-Triangle-Three-Buckets downsampling. At most threshold points are returned and the x coordinates are the
+// dates in milliseconds. Series that are already small enough are only converted.
+
+auto downsample_lttb(const QVector<qint64>& dates, const QVector<double>& values, const int& threshold)
+    -> QVector<QPointF>;
 
 auto add_tables_barseries_to_chart(QChart* chart,
-                                   const QVector<Table const*>& tables,
-                                   const QVector<int>& list_dates,
+                                   const QVector<Instrument const*>& tables,
+                                   const QVector<qint64>& list_dates,
                                    const QString& series_name,
                                    const QString& column_name)
     -> std::tuple<QStackedBarSeries*, QVector<QBarSet*>, QStringList>;
 
-auto get_unique_months_from_db(const QSqlDatabase& db, const QVector<Table const*>& tables, const int& last_n_months)
-    -> QVector<int>;
-
 #endif
\ No newline at end of file
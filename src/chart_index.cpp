@@ -0,0 +1,144 @@
+#include "chart_index.hpp"
+#include <algorithm>
+#include <limits>
+
+void ChartIndex::set_line(const QString& key,
+                          const QString& name,
+                          const QVector<qint64>& dates,
+                          const QVector<double>& values) {
+  lines.insert(key, {name, dates, values});
+}
+
+void ChartIndex::set_point(const QString& key, const QPointF& point) {
+  points.insert(key, point);
+}
+
+void ChartIndex::remove(const QString& key) {
+  lines.remove(key);
+  points.remove(key);
+}
+
+void ChartIndex::clear() {
+  lines.clear();
+  points.clear();
+  tree.clear();
+}
+
+void ChartIndex::build() {
+  tree.clear();
+
+  tree.reserve(points.size());
+
+  for (auto it = points.constBegin(); it != points.constEnd(); ++it) {
+    tree.append({it.key(), it.value()});
+  }
+
+  build_tree(0, tree.size(), 0);
+}
+
+auto ChartIndex::has_lines() const -> bool {
+  return !lines.empty();
+}
+
+auto ChartIndex::lines_at(const qint64& date) const -> QVector<Hit> {
+  QVector<Hit> hits;
+
+  hits.reserve(lines.size());
+
+  for (const auto& line : lines) {
+    const auto& dates = line.dates;
+
+    if (dates.empty() || date > dates.last()) {
+      continue;
+    }
+
+    // last row not after the date, the same rule asof_join_index() follows
+
+    const int n = int(std::upper_bound(dates.constBegin(), dates.constEnd(), date) - dates.constBegin()) - 1;
+
+    if (n < 0) {
+      continue;
+    }
+
+    hits.append({line.name, QPointF(dates[n], line.values[n])});
+  }
+
+  return hits;
+}
+
+auto ChartIndex::nearest_point(const QPointF& position, const double& xscale, const double& yscale, Hit& hit) const
+    -> bool {
+  if (tree.empty()) {
+    return false;
+  }
+
+  int best = -1;
+
+  double best_distance = std::numeric_limits<double>::max();
+
+  search(0, tree.size(), 0, position, xscale, yscale, best, best_distance);
+
+  hit = tree[best];
+
+  return true;
+}
+
+void ChartIndex::build_tree(const int& first, const int& last, const int& depth) {
+  if (last - first < 2) {
+    return;
+  }
+
+  const int middle = (first + last) / 2;
+
+  const bool by_x = depth % 2 == 0;
+
+  std::nth_element(tree.begin() + first, tree.begin() + middle, tree.begin() + last, [&](const Hit& a, const Hit& b) {
+    return by_x ? a.point.x() < b.point.x() : a.point.y() < b.point.y();
+  });
+
+  build_tree(first, middle, depth + 1);
+  build_tree(middle + 1, last, depth + 1);
+}
+
+void ChartIndex::search(const int& first,
+                        const int& last,
+                        const int& depth,
+                        const QPointF& position,
+                        const double& xscale,
+                        const double& yscale,
+                        int& best,
+                        double& best_distance) const {
+  if (first >= last) {
+    return;
+  }
+
+  const int middle = (first + last) / 2;
+
+  const auto& point = tree[middle].point;
+
+  const double dx = (point.x() - position.x()) * xscale;
+  const double dy = (point.y() - position.y()) * yscale;
+
+  if (const double distance = dx * dx + dy * dy; distance < best_distance) {
+    best = middle;
+    best_distance = distance;
+  }
+
+  // the side of the split holding the position first. The other one only when the split is closer than the best.
+
+  const double split = (depth % 2 == 0) ? dx : dy;
+
+  if (split > 0.0) {
+    search(first, middle, depth + 1, position, xscale, yscale, best, best_distance);
+
+    if (split * split < best_distance) {
+      search(middle + 1, last, depth + 1, position, xscale, yscale, best, best_distance);
+    }
+  } else {
+    search(middle + 1, last, depth + 1, position, xscale, yscale, best, best_distance);
+
+    if (split * split < best_distance) {
+      search(first, middle, depth + 1, position, xscale, yscale, best, best_distance);
+    }
+  }
+}
@@ -0,0 +1,75 @@
+#ifndef CHART_INDEX_HPP
+#define CHART_INDEX_HPP
+
+#include <QHash>
+#include <QPointF>
+#include <QString>
+#include <QVector>
+
+// Finds the chart points under the mouse without asking the series. Lines are searched with a binary search on their
+// sorted dates, so the values of every line at a date cost one lookup per line. Scatter points are kept in a kd-tree.
+//
+// The index holds shared copies of the full resolution data, not the points a SeriesPyramid leaves in the series.
+
+class ChartIndex {
+ public:
+  struct Hit {
+    QString name;
+
+    QPointF point;
+  };
+
+  void set_line(const QString& key, const QString& name, const QVector<qint64>& dates, const QVector<double>& values);
+
+  void set_point(const QString& key, const QPointF& point);
+
+  void remove(const QString& key);
+
+  void clear();
+
+  // must be called after the scatter points change and before nearest_point() is used
+
+  void build();
+
+  [[nodiscard]] auto has_lines() const -> bool;
+
+  // The last row of every line on or before the date. Lines starting after the date or ending before it are left out,
+  // so no value is carried past the end of its line.
+
+  [[nodiscard]] auto lines_at(const qint64& date) const -> QVector<Hit>;
+
+  // Scatter point nearest to the position. Distances along each axis are multiplied by its scale, which lets the
+  // caller measure them in pixels. Returns false when there are no points.
+
+  auto nearest_point(const QPointF& position, const double& xscale, const double& yscale, Hit& hit) const -> bool;
+
+ private:
+  struct Line {
+    QString name;
+
+    QVector<qint64> dates;
+    QVector<double> values;
+  };
+
+  QHash<QString, Line> lines;
+
+  QHash<QString, QPointF> points;
+
+  // The kd-tree is implicit: the median of a range is its root and the halves on each side are its subtrees. The
+  // split axis alternates with the depth starting with x.
+
+  QVector<Hit> tree;
+
+  void build_tree(const int& first, const int& last, const int& depth);
+
+  void search(const int& first,
+              const int& last,
+              const int& depth,
+              const QPointF& position,
+              const double& xscale,
+              const double& yscale,
+              int& best,
+              double& best_distance) const;
+};
+
+#endif
@@ -1,16 +1,18 @@
 #include "compare.hpp"
 #include <QSqlError>
 #include <QSqlQuery>
+#include "analysis_funcs.hpp"
 #include "chart_funcs.hpp"
 #include "effects.hpp"
-#include "math.hpp"
 
-Compare::Compare(const QSqlDatabase& database, QWidget* parent)
-    : db(database), chart(new QChart()), callout(new Callout(chart)) {
+Compare::Compare(const QSqlDatabase& database, Resampler* resampler, QWidget* parent)
+    : db(database),
+      chart(new QChart()),
+      binding(chart),
+      crosshair(chart, binding.index(), [this](const double& value) { return format_value(value); }),
+      resampler(resampler) {
   setupUi(this);
 
-  callout->hide();
-
   // shadow effects
 
   frame_chart->setGraphicsEffect(card_shadow());
@@ -30,9 +32,18 @@ Compare::Compare(const QSqlDatabase& database, QWidget* parent)
   chart_view->setRenderHint(QPainter::Antialiasing);
   chart_view->setRubberBand(QChartView::RectangleRubberBand);
 
+  crosshair.watch(chart_view);
+
+  // the axes are kept between updates. Only the series change.
+
+  add_axes_to_chart(chart, "%");
+
+  combo_frequency->addItems(frequency_names());
+
   // signals
 
   connect(button_reset_zoom, &QPushButton::clicked, this, [&]() { chart->zoomReset(); });
+  connect(combo_frequency, QOverload<int>::of(&QComboBox::currentIndexChanged), [&](int index) { process_tables(); });
 
   connect(radio_return_perc, &QRadioButton::toggled, this, &Compare::on_chart_selection);
   connect(radio_return_volatility, &QRadioButton::toggled, this, &Compare::on_chart_selection);
@@ -40,170 +51,72 @@ Compare::Compare(const QSqlDatabase& database, QWidget* parent)
   connect(radio_accumulated_return_second_derivative, &QRadioButton::toggled, this, &Compare::on_chart_selection);
 
   connect(spinbox_days, QOverload<int>::of(&QSpinBox::valueChanged), [&](int value) { process_tables(); });
-}
-
-void Compare::make_chart_return() {
-  chart->setTitle("Return");
-
-  add_axes_to_chart(chart, "%");
-
-  for (auto& table : tables) {
-    QVector<int> dates;
-    QVector<double> values;
-
-    for (int n = 0; n < table->model->rowCount() && n < spinbox_days->value(); n++) {
-      auto qdt = QDateTime::fromString(table->model->record(n).value("date").toString(), "dd/MM/yyyy");
-
-      dates.append(qdt.toSecsSinceEpoch());
-      values.append(table->model->record(n).value("return_perc").toDouble());
-    }
 
-    if (dates.size() < 2) {
-      continue;
+  connect(spinbox_rolling_window, QOverload<int>::of(&QSpinBox::valueChanged), [&](int value) {
+    if (radio_return_volatility->isChecked()) {
+      process_tables();
     }
-
-    const auto s = add_series_to_chart(chart, dates, values, table->name);
-
-    connect(s, &QLineSeries::hovered, this,
-            [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
-  }
+  });
 }
 
-void Compare::make_chart_return_volatility() {
-  chart->setTitle("Standard Deviation");
-
-  add_axes_to_chart(chart, "%");
-
-  for (auto& table : tables) {
-    QVector<int> dates;
-    QVector<double> values;
-
-    for (int n = 0; n < table->model->rowCount() && n < spinbox_days->value(); n++) {
-      auto qdt = QDateTime::fromString(table->model->record(n).value("date").toString(), "dd/MM/yyyy");
-
-      dates.append(qdt.toSecsSinceEpoch());
-      values.append(table->model->record(n).value("return_perc").toDouble());
-    }
-
-    if (dates.size() < 2) {
-      continue;
-    }
-
-    std::reverse(dates.begin(), dates.end());
-    std::reverse(values.begin(), values.end());
-
-    const auto s = add_series_to_chart(chart, dates, standard_deviation(values), table->name);
+void Compare::process(const QVector<Instrument const*>& tables) {
+  this->tables = tables;
 
-    connect(s, &QLineSeries::hovered, this,
-            [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
-  }
+  process_tables();
 }
 
-void Compare::make_chart_accumulated_return() {
-  chart->setTitle("Accumulated Return");
-
-  add_axes_to_chart(chart, "%");
-
-  for (auto& table : tables) {
-    QVector<int> dates;
-    QVector<double> vreturn;
-    QVector<double> accumulated_return;
-
-    for (int n = 0; n < table->model->rowCount() && dates.size() < spinbox_days->value(); n++) {
-      const auto qdt = QDateTime::fromString(table->model->record(n).value("date").toString(), "dd/MM/yyyy");
-
-      dates.append(qdt.toSecsSinceEpoch());
-      vreturn.append(table->model->record(n).value("return_perc").toDouble());
-    }
-
-    if (dates.size() < 2) {  // We need at least 2 points to show a line chart
-      continue;
-    }
-
-    std::reverse(vreturn.begin(), vreturn.end());
-
-    for (auto& value : vreturn) {
-      value = value * 0.01 + 1.0;
-    }
-
-    accumulated_return.resize(vreturn.size());
-
-    std::partial_sum(vreturn.begin(), vreturn.end(), accumulated_return.begin(), std::multiplies<>());
-
-    for (auto& value : accumulated_return) {
-      value = (value - 1.0) * 100;
-    }
-
-    std::reverse(accumulated_return.begin(), accumulated_return.end());
+auto Compare::selected_series(const Instrument* table) const -> const TimeSeries& {
+  return resampler->series(table->name, table->series, Frequency(combo_frequency->currentIndex()));
+}
 
-    const auto s = add_series_to_chart(chart, dates, accumulated_return, table->name.toUpper());
+void Compare::process_tables() {
+  CompareChart kind;
 
-    connect(s, &QLineSeries::hovered, this,
-            [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
+  if (radio_return_perc->isChecked()) {
+    kind = CompareChart::return_perc;
+  } else if (radio_return_volatility->isChecked()) {
+    kind = CompareChart::volatility;
+  } else if (radio_accumulated_return_perc->isChecked()) {
+    kind = CompareChart::accumulated_return;
+  } else if (radio_accumulated_return_second_derivative->isChecked()) {
+    kind = CompareChart::accumulated_return_second_derivative;
+  } else {
+    return;
   }
-}
 
-void Compare::make_chart_accumulated_return_second_derivative() {
-  chart->setTitle("Accumulated Return Second Derivative");
+  // the worker gets copies of the inputs
 
-  add_axes_to_chart(chart, "");
+  NamedSeries inputs;
 
   for (auto& table : tables) {
-    QVector<int> dates;
-    QVector<double> vreturn;
-    QVector<double> accumulated_return;
-
-    for (int n = 0; n < table->model->rowCount() && dates.size() < spinbox_days->value(); n++) {
-      const auto qdt = QDateTime::fromString(table->model->record(n).value("date").toString(), "dd/MM/yyyy");
-
-      dates.append(qdt.toSecsSinceEpoch());
-      vreturn.append(table->model->record(n).value("return_perc").toDouble());
-    }
-
-    if (dates.size() < 3) {  // We need at least 3 points to calculate the second derivative
-      continue;
-    }
-
-    std::reverse(dates.begin(), dates.end());
-    std::reverse(vreturn.begin(), vreturn.end());
-
-    for (auto& value : vreturn) {
-      value = value * 0.01 + 1.0;
-    }
+    inputs.append({table->name, selected_series(table)});
+  }
 
-    accumulated_return.resize(vreturn.size());
+  const int days = spinbox_days->value();
+  const int window = spinbox_rolling_window->value();
 
-    std::partial_sum(vreturn.begin(), vreturn.end(), accumulated_return.begin(), std::multiplies<>());
+  scheduler.schedule([this, inputs, kind, days, window](
+                         const RecomputeScheduler::IsCancelled& is_cancelled) -> RecomputeScheduler::Publish {
+    const auto lines = compare_lines(inputs, kind, days, window, is_cancelled);
 
-    for (auto& value : accumulated_return) {
-      value = (value - 1.0) * 100;
+    if (is_cancelled()) {
+      return {};
     }
 
-    const auto s = add_series_to_chart(chart, dates, second_derivative(accumulated_return), table->name);
+    return [this, lines, kind]() {
+      chart->setTitle(compare_title(kind));
 
-    connect(s, &QLineSeries::hovered, this,
-            [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
-  }
-}
+      chart->axes(Qt::Vertical)[0]->setTitleText(compare_unit(kind));
 
-void Compare::process(const QVector<Table const*>& tables) {
-  this->tables = tables;
+      binding.begin();
 
-  process_tables();
-}
+      for (const auto& line : lines) {
+        binding.set_line(line.key, line.dates, line.values);
+      }
 
-void Compare::process_tables() {
-  clear_chart(chart);
-
-  if (radio_return_perc->isChecked()) {
-    make_chart_return();
-  } else if (radio_return_volatility->isChecked()) {
-    make_chart_return_volatility();
-  } else if (radio_accumulated_return_perc->isChecked()) {
-    make_chart_accumulated_return();
-  } else if (radio_accumulated_return_second_derivative->isChecked()) {
-    make_chart_accumulated_return_second_derivative();
-  }
+      binding.end();
+    };
+  });
 }
 
 void Compare::on_chart_selection(const bool& state) {
@@ -214,29 +127,8 @@ void Compare::on_chart_selection(const bool& state) {
   process_tables();
 }
 
-void Compare::on_chart_mouse_hover(const QPointF& point, bool state, Callout* c, const QString& name) {
-  if (state) {
-    const auto qdt = QDateTime::fromMSecsSinceEpoch(point.x());
-
-    if (radio_return_perc->isChecked() || radio_accumulated_return_perc->isChecked()) {
-      c->setText(QString("Fund: %1\nDate: %2\nReturn: %3%")
-                     .arg(name, qdt.toString("MM/yyyy"), QString::number(point.y(), 'f', 2)));
-    } else if (radio_return_volatility->isChecked()) {
-      c->setText(QString("Fund: %1\nDate: %2\nValue: %3%")
-                     .arg(name, qdt.toString("MM/yyyy"), QString::number(point.y(), 'f', 2)));
-    } else if (radio_accumulated_return_second_derivative->isChecked()) {
-      c->setText(QString("Fund: %1\nDate: %2\nValue: %3")
-                     .arg(name, qdt.toString("MM/yyyy"), QString::number(point.y(), 'f', 2)));
-    }
-
-    c->setAnchor(point);
-
-    c->setZValue(11);
-
-    c->updateGeometry();
+auto Compare::format_value(const double& value) const -> QString {
+  const auto unit = radio_accumulated_return_second_derivative->isChecked() ? "" : "%";
 
-    c->show();
-  } else {
-    c->hide();
-  }
+  return QString::number(value, 'f', 2) + unit;
 }
@@ -3,35 +3,50 @@
 
 #include <QSqlDatabase>
 #include <deque>
-#include "callout.hpp"
-#include "table.hpp"
+#include "chart_binding.hpp"
+#include "chart_crosshair.hpp"
+#include "instrument.hpp"
+#include "recompute_scheduler.hpp"
+#include "resampler.hpp"
 #include "ui_compare.h"
 
 class Compare : public QWidget, protected Ui::Compare {
   Q_OBJECT
  public:
-  explicit Compare(const QSqlDatabase& database, QWidget* parent = nullptr);
+  explicit Compare(const QSqlDatabase& database, Resampler* resampler, QWidget* parent = nullptr);
 
-  void process(const QVector<Table const*>& tables);
+  void process(const QVector<Instrument const*>& tables);
 
  private:
   QSqlDatabase db;
 
   QChart* const chart;
 
-  Callout* const callout;
+  ChartBinding binding;
 
-  QVector<Table const*> tables;
+  ChartCrosshair crosshair;
+
+  QVector<Instrument const*> tables;
+
+  // shared by the analyses so a rollup is calculated only once
+
+  Resampler* const resampler;
+
+  // declared last so the running jobs are finished before the rest of the widget goes away
+
+  RecomputeScheduler scheduler;
 
   void process_tables();
 
-  void make_chart_return();
-  void make_chart_return_volatility();
-  void make_chart_accumulated_return();
-  void make_chart_accumulated_return_second_derivative();
+  // series of a table at the frequency selected for the analysis
+
+  auto selected_series(const Instrument* table) const -> const TimeSeries&;
 
   void on_chart_selection(const bool& state);
-  void on_chart_mouse_hover(const QPointF& point, bool state, Callout* c, const QString& name);
+
+  // value shown by the crosshair in the unit of the selected chart
+
+  [[nodiscard]] auto format_value(const double& value) const -> QString;
 };
 
 #endif
\ No newline at end of file
@@ -1,14 +1,16 @@
 #include "correlation.hpp"
+#include "analysis_funcs.hpp"
 #include "chart_funcs.hpp"
 #include "effects.hpp"
-#include "math.hpp"
 
-Correlation::Correlation(const QSqlDatabase& database, QWidget* parent)
-    : db(database), chart(new QChart()), callout(new Callout(chart)) {
+Correlation::Correlation(const QSqlDatabase& database, Resampler* resampler, QWidget* parent)
+    : db(database),
+      chart(new QChart()),
+      binding(chart),
+      crosshair(chart, binding.index()),
+      resampler(resampler) {
   setupUi(this);
 
-  callout->hide();
-
   // shadow effects
 
   frame_chart->setGraphicsEffect(card_shadow());
@@ -26,13 +28,26 @@ Correlation::Correlation(const QSqlDatabase& database, QWidget* parent)
   chart_view->setRenderHint(QPainter::Antialiasing);
   chart_view->setRubberBand(QChartView::RectangleRubberBand);
 
+  crosshair.watch(chart_view);
+
+  // the axes are kept between updates. Only the series change.
+
+  add_axes_to_chart(chart, "");
+
+  chart->setTitle("Correlation Coefficient");
+
+  combo_frequency->addItems(frequency_names());
+
   // signals
 
   connect(button_reset_zoom, &QPushButton::clicked, this, [&]() { chart->zoomReset(); });
+  connect(combo_frequency, QOverload<int>::of(&QComboBox::currentIndexChanged), [&](int index) { process_tables(); });
   connect(spinbox_months, QOverload<int>::of(&QSpinBox::valueChanged), [&](int value) { process_tables(); });
+  connect(spinbox_rolling_window, QOverload<int>::of(&QSpinBox::valueChanged), [&](int value) { process_tables(); });
+  connect(checkbox_carry_forward, &QCheckBox::toggled, this, [&]() { process_tables(); });
 }
 
-void Correlation::process(const QVector<Table const*>& tables) {
+void Correlation::process(const QVector<Instrument const*>& tables) {
   this->tables = tables;
 
   const auto current_text = combo_fund->currentText();
@@ -58,89 +73,44 @@ void Correlation::process(const QVector<Table const*>& tables) {
   process_tables();
 }
 
-void Correlation::process_tables() {
-  clear_chart(chart);
-
-  const auto dates = get_unique_months_from_db(db, tables, spinbox_months->value());
-
-  if (dates.empty()) {
-    return;
-  }
-
-  chart->setTitle("Correlation Coefficient");
+auto Correlation::selected_series(const Instrument* table) const -> const TimeSeries& {
+  return resampler->series(table->name, table->series, Frequency(combo_frequency->currentIndex()));
+}
 
-  add_axes_to_chart(chart, "");
+void Correlation::process_tables() {
+  // the worker gets copies of the inputs
 
-  QVector<double> values(dates.size(), 0.0);
+  NamedSeries inputs;
 
   for (auto& table : tables) {
-    if (table->name == combo_fund->currentText()) {
-      int count = 0;
-
-      for (auto& date : dates) {
-        for (int n = 0; n < table->model->rowCount(); n++) {
-          QString tdate = table->model->record(n).value("date").toString();
-
-          auto qdt = QDateTime::fromString(tdate, "dd/MM/yyyy");
-
-          if (qdt.toSecsSinceEpoch() == date) {
-            values[count] = table->model->record(n).value("return_perc").toDouble();
-          }
-        }
-
-        count++;
-      }
-
-      break;
-    }
+    inputs.append({table->name, selected_series(table)});
   }
 
-  for (auto& table : tables) {
-    if (table->name != combo_fund->currentText()) {
-      QVector<double> tvalues(dates.size(), 0.0);
-      int count = 0;
-
-      for (auto& date : dates) {
-        for (int n = 0; n < table->model->rowCount(); n++) {
-          QString tdate = table->model->record(n).value("date").toString();
-
-          auto qdt = QDateTime::fromString(tdate, "dd/MM/yyyy");
+  const auto fund = combo_fund->currentText();
 
-          if (qdt.toSecsSinceEpoch() == date) {
-            tvalues[count] = table->model->record(n).value("return_perc").toDouble();
-          }
-        }
+  const int months = spinbox_months->value();
+  const int window = spinbox_rolling_window->value();
 
-        count++;
-      }
+  const auto mode = checkbox_carry_forward->isChecked() ? JoinMode::asof : JoinMode::exact;
 
-      auto s = add_series_to_chart(chart, dates, correlation_coefficient(values, tvalues), table->name);
+  scheduler.schedule([this, inputs, fund, months, window, mode](
+                         const RecomputeScheduler::IsCancelled& is_cancelled) -> RecomputeScheduler::Publish {
+    const auto lines = correlation_lines(inputs, fund, months, window, mode, is_cancelled);
 
-      connect(s, &QLineSeries::hovered, this,
-              [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout, s->name()); });
+    if (is_cancelled()) {
+      return {};
     }
-  }
-
-  chart->axes(Qt::Vertical)[0]->setRange(-1.0, 1.0);
-}
-
-void Correlation::on_chart_mouse_hover(const QPointF& point, bool state, Callout* c, const QString& name) {
-  if (state) {
-    auto qdt = QDateTime();
 
-    qdt.setMSecsSinceEpoch(point.x());
+    return [this, lines]() {
+      binding.begin();
 
-    c->setText(QString("Fund: %1\nDate: %2\nCorrelation: %3")
-                   .arg(name, qdt.toString("dd/MM/yyyy"), QString::number(point.y(), 'f', 2)));
-
-    c->setAnchor(point);
-
-    c->setZValue(11);
+      for (const auto& line : lines) {
+        binding.set_line(line.key, line.dates, line.values);
+      }
 
-    c->updateGeometry();
+      binding.end();
 
-    c->show();
-  } else {
-    c->hide();
-  }
+      chart->axes(Qt::Vertical)[0]->setRange(-1.0, 1.0);
+    };
+  });
 }
\ No newline at end of file
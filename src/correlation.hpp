@@ -2,29 +2,44 @@
 #define CORRELATION_HPP
 
 #include <QSqlDatabase>
-#include "callout.hpp"
-#include "table.hpp"
+#include "chart_binding.hpp"
+#include "chart_crosshair.hpp"
+#include "instrument.hpp"
+#include "recompute_scheduler.hpp"
+#include "resampler.hpp"
 #include "ui_correlation.h"
 
 class Correlation : public QWidget, protected Ui::Correlation {
   Q_OBJECT
  public:
-  explicit Correlation(const QSqlDatabase& database, QWidget* parent = nullptr);
+  explicit Correlation(const QSqlDatabase& database, Resampler* resampler, QWidget* parent = nullptr);
 
-  void process(const QVector<Table const*>& tables);
+  void process(const QVector<Instrument const*>& tables);
 
  private:
   QSqlDatabase db;
 
   QChart* const chart;
 
-  Callout* const callout;
+  ChartBinding binding;
 
-  QVector<Table const*> tables;
+  ChartCrosshair crosshair;
+
+  QVector<Instrument const*> tables;
+
+  // shared by the analyses so a rollup is calculated only once
+
+  Resampler* const resampler;
+
+  // declared last so the running jobs are finished before the rest of the widget goes away
+
+  RecomputeScheduler scheduler;
 
   void process_tables();
 
-  static void on_chart_mouse_hover(const QPointF& point, bool state, Callout* c, const QString& name);
+  // series of a table at the frequency selected for the analysis
+
+  auto selected_series(const Instrument* table) const -> const TimeSeries&;
 };
 
 #endif
\ No newline at end of file
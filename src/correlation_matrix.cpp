@@ -0,0 +1,230 @@
+#include "correlation_matrix.hpp"
+#include <QElapsedTimer>
+#include <QMouseEvent>
+#include <algorithm>
+#include <cmath>
+#include "alignment.hpp"
+#include "effects.hpp"
+
+namespace {
+
+auto correlation_color(const double& value) -> QRgb {
+  // diverging color map: blue for -1, white for 0 and red for +1
+
+  const double v = std::clamp(value, -1.0, 1.0);
+
+  const int fade = static_cast<int>(255 * (1.0 - std::fabs(v)));
+
+  if (v >= 0) {
+    return qRgb(255, fade, fade);
+  }
+
+  return qRgb(fade, fade, 255);
+}
+
+// Pearson correlation of the returns of every pair of series over the latest months rows. Empty when there are fewer
+// than two series or no rows.
+
+auto correlation_matrix(const QVector<TimeSeries>& series,
+                        const int& months,
+                        const JoinMode& mode,
+                        const RecomputeScheduler::IsCancelled& is_cancelled) -> Eigen::MatrixXd {
+  QVector<TimeSeries const*> pointers;
+
+  for (auto& s : series) {
+    pointers.append(&s);
+  }
+
+  const auto dates = latest_dates(pointers, months);
+
+  if (dates.empty() || series.size() < 2) {
+    return {};
+  }
+
+  // Each column holds the returns of one table aligned to the common dates
+
+  Eigen::MatrixXd data(dates.size(), series.size());
+
+  const int n_tables = series.size();
+
+#pragma omp parallel for schedule(dynamic)
+  for (int k = 0; k < n_tables; k++) {
+    const auto returns = aligned_returns(series.at(k), dates, mode);
+
+    data.col(k) = Eigen::Map<const Eigen::VectorXd>(returns.constData(), returns.size());
+  }
+
+  if (is_cancelled()) {
+    return {};
+  }
+
+  // Standardizing every column to zero mean and unit norm. After that the whole Pearson matrix is a single product.
+
+  const int n_cols = static_cast<int>(data.cols());
+
+#pragma omp parallel for schedule(static)
+  for (int k = 0; k < n_cols; k++) {
+    data.col(k).array() -= data.col(k).mean();
+
+    const double norm = data.col(k).norm();
+
+    const double tol = 0.0001;
+
+    if (norm > tol) {
+      data.col(k) /= norm;
+    } else {
+      data.col(k).setZero();
+    }
+  }
+
+  // Eigen computes the product with its cache blocked kernel and spreads it over the OpenMP threads
+
+  Eigen::MatrixXd correlations = data.transpose() * data;
+
+  correlations.diagonal().setOnes();
+
+  return correlations;
+}
+
+auto make_heatmap(const Eigen::MatrixXd& correlations) -> QImage {
+  const int size = static_cast<int>(correlations.rows());
+
+  QImage heatmap(size, size, QImage::Format_RGB32);
+
+  // bits() detaches the image before the threads start writing to it
+
+  auto* const pixels = reinterpret_cast<QRgb*>(heatmap.bits());
+
+  const int stride = heatmap.bytesPerLine() / static_cast<int>(sizeof(QRgb));
+
+#pragma omp parallel for schedule(static)
+  for (int row = 0; row < size; row++) {
+    for (int col = 0; col < size; col++) {
+      pixels[row * stride + col] = correlation_color(correlations(row, col));
+    }
+  }
+
+  return heatmap;
+}
+
+}  // namespace
+
+CorrelationMatrix::CorrelationMatrix(const QSqlDatabase& database, QWidget* parent) : db(database) {
+  setupUi(this);
+
+  // shadow effects
+
+  frame_chart->setGraphicsEffect(card_shadow());
+  frame_time_window->setGraphicsEffect(card_shadow());
+
+  label_heatmap->installEventFilter(this);
+
+  // signals
+
+  connect(spinbox_months, QOverload<int>::of(&QSpinBox::valueChanged), [&](int value) { process_tables(); });
+  connect(checkbox_carry_forward, &QCheckBox::toggled, this, [&]() { process_tables(); });
+}
+
+void CorrelationMatrix::process(const QVector<Instrument const*>& tables) {
+  this->tables = tables;
+
+  process_tables();
+}
+
+void CorrelationMatrix::process_tables() {
+  // The matrix and its image are calculated in the thread pool from copies of the series. Only the latest is shown.
+
+  QStringList table_names;
+
+  QVector<TimeSeries> series;
+
+  for (auto& table : tables) {
+    table_names.append(table->name);
+
+    series.append(table->series);
+  }
+
+  const int months = spinbox_months->value();
+
+  const auto mode = checkbox_carry_forward->isChecked() ? JoinMode::asof : JoinMode::exact;
+
+  scheduler.schedule([this, table_names, series, months, mode](
+                         const RecomputeScheduler::IsCancelled& is_cancelled) -> RecomputeScheduler::Publish {
+    QElapsedTimer timer;
+
+    timer.start();
+
+    const auto matrix = correlation_matrix(series, months, mode, is_cancelled);
+
+    if (is_cancelled()) {
+      return {};
+    }
+
+    const auto image = (matrix.size() > 0) ? make_heatmap(matrix) : QImage();
+
+    const auto elapsed = timer.elapsed();
+
+    return [this, table_names, matrix, image, elapsed]() {
+      names = table_names;
+
+      correlations = matrix;
+
+      heatmap = image;
+
+      update_pixmap();
+
+      if (!heatmap.isNull()) {
+        label_elapsed->setText(
+            QString("%1 x %2 in %3 ms").arg(correlations.cols()).arg(correlations.cols()).arg(elapsed));
+      }
+    };
+  });
+}
+
+void CorrelationMatrix::update_pixmap() {
+  if (heatmap.isNull()) {
+    label_heatmap->clear();
+
+    heatmap_rect = QRect();
+
+    return;
+  }
+
+  const auto pixmap = QPixmap::fromImage(
+      heatmap.scaled(label_heatmap->size(), Qt::KeepAspectRatio, Qt::FastTransformation));
+
+  heatmap_rect = QRect(QPoint(0, 0), pixmap.size());
+
+  heatmap_rect.moveCenter(label_heatmap->rect().center());
+
+  label_heatmap->setPixmap(pixmap);
+}
+
+void CorrelationMatrix::resizeEvent(QResizeEvent* event) {
+  QWidget::resizeEvent(event);
+
+  update_pixmap();
+}
+
+auto CorrelationMatrix::eventFilter(QObject* object, QEvent* event) -> bool {
+  if (object == label_heatmap && event->type() == QEvent::MouseMove && !heatmap_rect.isEmpty()) {
+    const auto pos = dynamic_cast<QMouseEvent*>(event)->pos();
+
+    if (heatmap_rect.contains(pos)) {
+      const auto size = static_cast<int>(correlations.rows());
+
+      const int col = (pos.x() - heatmap_rect.left()) * size / heatmap_rect.width();
+      const int row = (pos.y() - heatmap_rect.top()) * size / heatmap_rect.height();
+
+      if (row < size && col < size) {
+        label_selection->setText(QString("%1 x %2: %3")
+                                     .arg(names[row], names[col],
+                                          QString::number(correlations(row, col), 'f', 2)));
+      }
+    } else {
+      label_selection->clear();
+    }
+  }
+
+  return QWidget::eventFilter(object, event);
+}
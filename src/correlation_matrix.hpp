@@ -0,0 +1,43 @@
+#ifndef CORRELATION_MATRIX_HPP
+#define CORRELATION_MATRIX_HPP
+
+#include <QImage>
+#include <QSqlDatabase>
+#include <Eigen/Core>
+#include "instrument.hpp"
+#include "recompute_scheduler.hpp"
+#include "ui_correlation_matrix.h"
+
+class CorrelationMatrix : public QWidget, protected Ui::CorrelationMatrix {
+  Q_OBJECT
+ public:
+  explicit CorrelationMatrix(const QSqlDatabase& database, QWidget* parent = nullptr);
+
+  void process(const QVector<Instrument const*>& tables);
+
+ protected:
+  auto eventFilter(QObject* object, QEvent* event) -> bool override;
+  void resizeEvent(QResizeEvent* event) override;
+
+ private:
+  QSqlDatabase db;
+
+  QVector<Instrument const*> tables;
+
+  // the last result published. The names are the ones of the tables it was calculated from.
+
+  QStringList names;
+
+  Eigen::MatrixXd correlations;
+
+  QImage heatmap;
+
+  QRect heatmap_rect;
+
+  RecomputeScheduler scheduler;
+
+  void process_tables();
+  void update_pixmap();
+};
+
+#endif
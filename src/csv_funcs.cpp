@@ -0,0 +1,555 @@
+#include "csv_funcs.hpp"
+#include <QDate>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QThread>
+#include <QTimeZone>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr qint64 msecs_per_second = 1000;
+constexpr qint64 msecs_per_day = 86400 * msecs_per_second;
+
+// epoch timestamps with more digits than this are taken as milliseconds. Seconds only get there after the year 5138.
+
+constexpr size_t max_epoch_seconds_digits = 11;
+
+// files smaller than this are not worth splitting among threads
+
+constexpr qint64 min_chunk_size = 1 << 20;
+
+// https://howardhinnant.github.io/date_algorithms.html#days_from_civil
+
+auto days_from_civil(int y, const int& m, const int& d) -> qint64 {
+  y -= static_cast<int>(m <= 2);
+
+  const int era = (y >= 0 ? y : y - 399) / 400;
+  const int yoe = y - era * 400;
+  const int doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+  return qint64(era) * 146097 + doe - 719468;
+}
+
+// Converts a local wall clock time, given in milliseconds as if it were UTC, to milliseconds since epoch. The time
+// zone is only asked again when the time falls outside the interval between the two transitions its offset was taken
+// from.
+
+class LocalTime {
+ public:
+  auto operator()(const qint64& wall_clock) -> qint64 {
+    qint64 t = wall_clock - offset;
+
+    if (t < valid_from || t >= valid_until) {
+      offset = qint64(zone.offsetFromUtc(QDateTime::fromMSecsSinceEpoch(wall_clock, Qt::UTC))) * msecs_per_second;
+
+      t = wall_clock - offset;
+
+      const auto dt = QDateTime::fromMSecsSinceEpoch(t, Qt::UTC);
+
+      offset = qint64(zone.offsetFromUtc(dt)) * msecs_per_second;
+
+      t = wall_clock - offset;
+
+      const auto previous = zone.previousTransition(dt);
+      const auto next = zone.nextTransition(dt);
+
+      valid_from = previous.atUtc.isValid() ? previous.atUtc.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min();
+      valid_until = next.atUtc.isValid() ? next.atUtc.toMSecsSinceEpoch() : std::numeric_limits<qint64>::max();
+    }
+
+    return t;
+  }
+
+ private:
+  QTimeZone zone = QTimeZone::systemTimeZone();
+
+  qint64 offset = 0;
+
+  qint64 valid_from = 1;
+  qint64 valid_until = 0;
+};
+
+auto is_padding(const char& c) -> bool {
+  return c == ' ' || c == '"' || c == '\r' || c == '\t';
+}
+
+auto trim(std::string_view field) -> std::string_view {
+  while (!field.empty() && is_padding(field.front())) {
+    field.remove_prefix(1);
+  }
+
+  while (!field.empty() && is_padding(field.back())) {
+    field.remove_suffix(1);
+  }
+
+  return field;
+}
+
+template <class T>
+auto to_integer(const std::string_view& field, T& value) -> bool {
+  const auto [ptr, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+
+  return ec == std::errc() && ptr == field.data() + field.size();
+}
+
+// year, month and day written at the given positions of a date field
+
+auto to_ymd(const std::string_view& field,
+            const size_t& y_pos,
+            const size_t& m_pos,
+            const size_t& d_pos,
+            int& y,
+            int& m,
+            int& d) -> bool {
+  return to_integer(field.substr(y_pos, 4), y) && to_integer(field.substr(m_pos, 2), m) &&
+         to_integer(field.substr(d_pos, 2), d);
+}
+
+// fields of a line split at the delimiters that are not inside quotes
+
+auto split_line(const std::string_view& line, const char& delimiter) -> std::vector<std::string_view> {
+  std::vector<std::string_view> fields;
+
+  bool quoted = false;
+  size_t start = 0;
+
+  for (size_t n = 0; n < line.size(); n++) {
+    if (line[n] == '"') {
+      quoted = !quoted;
+    } else if (line[n] == delimiter && !quoted) {
+      fields.push_back(line.substr(start, n - start));
+
+      start = n + 1;
+    }
+  }
+
+  fields.push_back(line.substr(start));
+
+  return fields;
+}
+
+// same as split_line but only the two columns we need are kept and nothing is allocated
+
+auto pick_fields(const std::string_view& line,
+                 const char& delimiter,
+                 const int& date_column,
+                 const int& value_column,
+                 std::string_view& date,
+                 std::string_view& value) -> bool {
+  const int last_column = std::max(date_column, value_column);
+
+  bool quoted = false;
+  int column = 0;
+  size_t start = 0;
+
+  for (size_t n = 0; n <= line.size() && column <= last_column; n++) {
+    if (n < line.size() && line[n] == '"') {
+      quoted = !quoted;
+    } else if (n == line.size() || (line[n] == delimiter && !quoted)) {
+      if (column == date_column) {
+        date = line.substr(start, n - start);
+      }
+
+      if (column == value_column) {
+        value = line.substr(start, n - start);
+      }
+
+      column++;
+
+      start = n + 1;
+    }
+  }
+
+  return column > last_column;
+}
+
+auto lower_case(std::string_view field) -> std::string {
+  std::string output(trim(field));
+
+  std::transform(output.begin(), output.end(), output.begin(), [](unsigned char c) { return std::tolower(c); });
+
+  return output;
+}
+
+struct ChunkResult {
+  std::vector<qint64> dates;
+  std::vector<double> values;
+
+  int rejected = 0;
+};
+
+// Time of the day written after a date as hh:mm, hh:mm:ss or hh:mm:ss.zzz. Fractions with more digits than the
+// milliseconds are truncated.
+
+auto parse_time_of_day(std::string_view field, qint64& msecs) -> bool {
+  int h = 0;
+  int m = 0;
+  int s = 0;
+  int ms = 0;
+
+  if (field.size() < 5 || field[2] != ':' || !to_integer(field.substr(0, 2), h) || !to_integer(field.substr(3, 2), m)) {
+    return false;
+  }
+
+  field.remove_prefix(5);
+
+  if (!field.empty()) {
+    if (field.size() < 3 || field[0] != ':' || !to_integer(field.substr(1, 2), s)) {
+      return false;
+    }
+
+    field.remove_prefix(3);
+  }
+
+  if (!field.empty()) {
+    if (field.size() < 2 || (field[0] != '.' && field[0] != ',')) {
+      return false;
+    }
+
+    const auto fraction = field.substr(1);
+
+    for (size_t n = 0; n < fraction.size(); n++) {
+      if (std::isdigit(static_cast<unsigned char>(fraction[n])) == 0) {
+        return false;
+      }
+
+      if (n < 3) {
+        ms = 10 * ms + (fraction[n] - '0');
+      }
+    }
+
+    for (size_t n = fraction.size(); n < 3; n++) {
+      ms *= 10;
+    }
+  }
+
+  if (h > 23 || m > 59 || s > 59) {
+    return false;
+  }
+
+  msecs = ((h * 60 + m) * 60 + s) * msecs_per_second + ms;
+
+  return true;
+}
+
+}  // namespace
+
+auto parse_date(std::string_view field, qint64& date) -> bool {
+  thread_local LocalTime local_time;
+
+  field = trim(field);
+
+  int y = 0;
+  int m = 0;
+  int d = 0;
+
+  bool valid = false;
+
+  constexpr size_t date_size = 10;
+
+  if (field.size() >= 10 && field[4] == '-' && field[7] == '-') {  // yyyy-MM-dd
+    valid = to_ymd(field, 0, 5, 8, y, m, d);
+  } else if (field.size() >= 10 && field[2] == '/' && field[5] == '/') {  // dd/MM/yyyy
+    valid = to_ymd(field, 6, 3, 0, y, m, d);
+  } else if (field.size() == 8) {  // yyyyMMdd
+    valid = to_ymd(field, 0, 4, 6, y, m, d);
+  } else {  // seconds or milliseconds since epoch
+    if (field.empty() || !to_integer(field, date)) {
+      return false;
+    }
+
+    const size_t digits = field.size() - size_t(field[0] == '-');
+
+    date *= (digits > max_epoch_seconds_digits) ? 1 : msecs_per_second;
+
+    return true;
+  }
+
+  if (!valid || !QDate::isValid(y, m, d)) {
+    return false;
+  }
+
+  // An optional time follows after a space or a T. Anything else after the date, like a time zone, is ignored.
+
+  qint64 time_of_day = 0;
+
+  if (field.size() > date_size + 1 && (field[date_size] == ' ' || field[date_size] == 'T')) {
+    auto time = trim(field.substr(date_size + 1));
+
+    const auto end = time.find_first_not_of("0123456789:.,");
+
+    if (!parse_time_of_day(time.substr(0, end), time_of_day)) {
+      return false;
+    }
+  }
+
+  date = local_time(days_from_civil(y, m, d) * msecs_per_day + time_of_day);
+
+  return true;
+}
+
+auto format_date(const qint64& date) -> QString {
+  const auto qdt = QDateTime::fromMSecsSinceEpoch(date);
+
+  if (qdt.time() == QTime(0, 0)) {
+    return qdt.toString("dd/MM/yyyy");
+  }
+
+  return qdt.toString(qdt.time().msec() == 0 ? "dd/MM/yyyy hh:mm:ss" : "dd/MM/yyyy hh:mm:ss.zzz");
+}
+
+auto parse_number(std::string_view field, double& value, const char& decimal_point) -> bool {
+  field = trim(field);
+
+  if (field.empty()) {
+    return false;
+  }
+
+  char decimal = decimal_point;
+
+  if (decimal != '.' && decimal != ',') {
+    // the separator found last is taken as the decimal one
+
+    const auto last_comma = field.rfind(',');
+    const auto last_dot = field.rfind('.');
+
+    decimal = (last_comma != std::string_view::npos && (last_dot == std::string_view::npos || last_comma > last_dot))
+                  ? ','
+                  : '.';
+  }
+
+  // the other separator only groups thousands
+
+  const char group = (decimal == ',') ? '.' : ',';
+
+  std::array<char, 64> buffer{};
+
+  if (decimal == ',' || field.find(group) != std::string_view::npos) {
+    size_t size = 0;
+
+    for (const char& c : field) {
+      if (size == buffer.size()) {
+        return false;
+      }
+
+      if (c == decimal) {
+        buffer[size++] = '.';
+      } else if (c != group) {
+        buffer[size++] = c;
+      }
+    }
+
+    field = std::string_view(buffer.data(), size);
+  }
+
+  const auto [ptr, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+
+  return ec == std::errc() && ptr == field.data() + field.size();
+}
+
+auto parse_csv(const QString& path, TimeSeries& series) -> bool {
+  QFile file(path);
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    qDebug() << "failed to open " + path.toUtf8() + ": " + file.errorString().toUtf8();
+
+    return false;
+  }
+
+  if (file.size() == 0) {
+    return false;
+  }
+
+  const auto* data = reinterpret_cast<const char*>(file.map(0, file.size()));
+
+  if (data == nullptr) {
+    qDebug() << "failed to map " + path.toUtf8() + ": " + file.errorString().toUtf8();
+
+    return false;
+  }
+
+  return parse_csv(data, data + file.size(), series);
+}
+
+auto parse_csv(const char* begin, const char* end, TimeSeries& series) -> bool {
+  series.clear();
+
+  // The first line tells the delimiter and whether there is a header naming the columns
+
+  const auto* first_line_end = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+
+  if (first_line_end == nullptr) {
+    first_line_end = end;
+  }
+
+  const auto first_line = std::string_view(begin, first_line_end - begin);
+
+  char delimiter = ',';
+
+  for (const char& c : {';', '\t'}) {
+    const auto count = [&](const char& x) { return std::count(first_line.begin(), first_line.end(), x); };
+
+    if (count(c) > count(delimiter)) {
+      delimiter = c;
+    }
+  }
+
+  const auto header = split_line(first_line, delimiter);
+
+  int date_column = 0;
+  int value_column = 1;
+
+  const char* body = begin;
+
+  if (qint64 first_date = 0; !parse_date(header[0], first_date)) {
+    body = std::min(first_line_end + 1, end);
+
+    std::vector<std::string> names;
+
+    for (auto& field : header) {
+      names.push_back(lower_case(field));
+    }
+
+    for (auto& name : {"date", "timestamp", "time"}) {
+      if (auto it = std::find(names.begin(), names.end(), name); it != names.end()) {
+        date_column = int(it - names.begin());
+
+        break;
+      }
+    }
+
+    for (auto& name : {"adj close", "adj_close", "close", "value", "price"}) {
+      if (auto it = std::find(names.begin(), names.end(), name); it != names.end()) {
+        value_column = int(it - names.begin());
+
+        break;
+      }
+    }
+  }
+
+  // Each chunk starts right after a line break so that no line is shared by two threads
+
+  const qint64 body_size = end - body;
+
+  const int n_chunks =
+      int(std::clamp(body_size / min_chunk_size, qint64(1), qint64(std::max(1, QThread::idealThreadCount()))));
+
+  std::vector<const char*> bounds(n_chunks + 1, end);
+
+  bounds[0] = body;
+
+  for (int n = 1; n < n_chunks; n++) {
+    const char* p = std::max(body + n * body_size / n_chunks, bounds[n - 1]);
+
+    const auto* line_break = static_cast<const char*>(std::memchr(p, '\n', end - p));
+
+    bounds[n] = (line_break != nullptr) ? line_break + 1 : end;
+  }
+
+  std::vector<ChunkResult> chunks(n_chunks);
+
+#pragma omp parallel for schedule(static)
+  for (int n = 0; n < n_chunks; n++) {
+    auto& chunk = chunks[n];
+
+    chunk.dates.reserve((bounds[n + 1] - bounds[n]) / 16);
+    chunk.values.reserve((bounds[n + 1] - bounds[n]) / 16);
+
+    const char* p = bounds[n];
+
+    while (p < bounds[n + 1]) {
+      const auto* line_break = static_cast<const char*>(std::memchr(p, '\n', bounds[n + 1] - p));
+      const char* line_end = (line_break != nullptr) ? line_break : bounds[n + 1];
+
+      const auto line = std::string_view(p, line_end - p);
+
+      p = line_end + 1;
+
+      if (trim(line).empty()) {
+        continue;
+      }
+
+      std::string_view date_field;
+      std::string_view value_field;
+
+      qint64 date = 0;
+      double value = 0.0;
+
+      if (pick_fields(line, delimiter, date_column, value_column, date_field, value_field) &&
+          parse_date(date_field, date) && parse_number(value_field, value)) {
+        chunk.dates.push_back(date);
+        chunk.values.push_back(value);
+      } else {
+        chunk.rejected++;
+      }
+    }
+  }
+
+  size_t n_rows = 0;
+  int rejected = 0;
+
+  for (auto& chunk : chunks) {
+    n_rows += chunk.dates.size();
+    rejected += chunk.rejected;
+  }
+
+  if (rejected > 0) {
+    qDebug() << "lines that could not be parsed:" << rejected;
+  }
+
+  std::vector<qint64> dates;
+  std::vector<double> values;
+
+  dates.reserve(n_rows);
+  values.reserve(n_rows);
+
+  for (auto& chunk : chunks) {
+    dates.insert(dates.end(), chunk.dates.begin(), chunk.dates.end());
+    values.insert(values.end(), chunk.values.begin(), chunk.values.end());
+  }
+
+  // Files are usually written in chronological or reverse chronological order. Anything else is sorted.
+
+  std::vector<size_t> order(n_rows);
+
+  std::iota(order.begin(), order.end(), 0);
+
+  if (std::is_sorted(dates.rbegin(), dates.rend()) && !std::is_sorted(dates.begin(), dates.end())) {
+    std::reverse(order.begin(), order.end());
+  } else if (!std::is_sorted(dates.begin(), dates.end())) {
+    std::stable_sort(order.begin(), order.end(), [&](const size_t& a, const size_t& b) { return dates[a] < dates[b]; });
+  }
+
+  series.dates.reserve(int(n_rows));
+  series.values.reserve(int(n_rows));
+
+  for (size_t n = 0; n < n_rows; n++) {
+    // only the row written last in the file is kept when a date is repeated
+
+    size_t row = order[n];
+
+    while (n + 1 < n_rows && dates[order[n + 1]] == dates[row]) {
+      row = std::max(row, order[++n]);
+    }
+
+    series.dates.append(dates[row]);
+    series.values.append(values[row]);
+  }
+
+  series.ids.resize(series.size());
+  series.return_perc.resize(series.size());
+  series.accumulated_return_perc.resize(series.size());
+
+  return !series.empty();
+}
@@ -0,0 +1,31 @@
+#ifndef CSV_FUNCS_HPP
+#define CSV_FUNCS_HPP
+
+#include <QString>
+#include <string_view>
+#include "time_series.hpp"
+
+// Parsers used to bring price histories from text files. Dates may be written as yyyy-MM-dd, dd/MM/yyyy or yyyyMMdd
+// optionally followed by a local time (hh:mm[:ss[.zzz]]), or as seconds or milliseconds since epoch. The result is in
+// milliseconds since epoch and a date without a time is placed at its local midnight like the dates typed in a table.
+
+auto parse_date(std::string_view field, qint64& date) -> bool;
+
+// Text written in the tables for a date in milliseconds since epoch. The time is only shown when it is not midnight.
+// parse_date reads it back.
+
+auto format_date(const qint64& date) -> QString;
+
+// Without a decimal point the separator found last in the field is taken as the decimal one
+
+auto parse_number(std::string_view field, double& value, const char& decimal_point = 0) -> bool;
+
+// The file is memory mapped and its lines are split among the available cores. The value column is the one named
+// "adj close", "close", "value" or "price" when there is a header and the second column otherwise. The rows are sorted
+// by date and only the last one of a repeated date is kept. The returns are not calculated.
+
+auto parse_csv(const QString& path, TimeSeries& series) -> bool;
+
+auto parse_csv(const char* begin, const char* end, TimeSeries& series) -> bool;
+
+#endif
@@ -0,0 +1,682 @@
+#include "db_funcs.hpp"
+#include <QDebug>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariantList>
+
+namespace {
+
+// increased every time migrate_schema() learns a new step
+
+constexpr int schema_version = 3;
+
+// Dates are stored as milliseconds since epoch. strftime('%s') only has whole seconds.
+
+constexpr auto current_msecs = "(cast((julianday('now') - 2440587.5) * 86400000 as int))";
+
+// The version of an instrument is bumped whenever one of its rows changes. Writing the returns does not count because
+// they are derived from the date and value columns.
+
+auto create_instrument_version_triggers(const QSqlDatabase& db) -> bool {
+  auto query = QSqlQuery(db);
+
+  const QString bump = "update series_versions set version = version + 1 where name = (select name from instruments";
+
+  const QVector<QString> statements = {
+      "create trigger if not exists prices_version_insert after insert on prices begin " + bump +
+          " where id = new.instrument_id); end",
+      "create trigger if not exists prices_version_update after update of instrument_id, date, value on prices begin " +
+          bump + " where id = old.instrument_id); " + bump + " where id = new.instrument_id); end",
+      "create trigger if not exists prices_version_delete after delete on prices begin " + bump +
+          " where id = old.instrument_id); end"};
+
+  for (auto& statement : statements) {
+    if (!query.exec(statement)) {
+      qDebug() << "failed to create the prices version triggers: " + query.lastError().text().toUtf8();
+
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// The steps taking the schema from version to schema_version. Stops at the first one that fails.
+
+auto migrate_steps(QSqlDatabase& db, const int& version) -> bool {
+  auto query = QSqlQuery(db);
+
+  const auto exec = [&](const QString& statement) {
+    if (!query.exec(statement)) {
+      qDebug() << "failed to run " + statement.toUtf8() + ": " + query.lastError().text().toUtf8();
+
+      return false;
+    }
+
+    return true;
+  };
+
+  const auto tables = list_stock_tables(db);
+
+  const bool long_format = long_format_enabled(db);
+
+  if (version < 1) {  // every table ordered by date gets an index on it
+    for (auto& name : tables) {
+      if (!create_date_index(db, name)) {
+        return false;
+      }
+    }
+  }
+
+  if (version < 2) {  // the series cache needs to know when the rows of a table change
+    if (!exec("create table if not exists series_versions"
+              " (name text primary key, version integer not null default 0)")) {
+      return false;
+    }
+
+    for (auto& name : tables) {
+      if (!create_version_triggers(db, name) || !bump_series_version(db, name)) {
+        return false;
+      }
+    }
+
+    if (long_format) {
+      if (!create_instrument_version_triggers(db)) {
+        return false;
+      }
+
+      for (auto& instrument : list_instruments(db)) {
+        if (!bump_series_version(db, instrument.second)) {
+          return false;
+        }
+      }
+    }
+  }
+
+  if (version < 3) {  // dates go from seconds to milliseconds since epoch
+    for (auto& name : tables) {
+      if (!exec("update " + name + " set date = date * 1000")) {
+        return false;
+      }
+    }
+
+    if (long_format && !exec("update prices set date = date * 1000")) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace
+
+void apply_storage_profile(const QSqlDatabase& db) {
+  // Write ahead logging lets readers work while a table is saved and with it synchronous=normal is still safe against
+  // corruption. The page cache and the memory map are sized for databases of a few gigabytes.
+
+  const QVector<QString> pragmas = {"pragma journal_mode = wal", "pragma synchronous = normal",
+                                    "pragma mmap_size = 1073741824", "pragma cache_size = -131072",
+                                    "pragma temp_store = memory"};
+
+  for (auto& pragma : pragmas) {
+    auto query = QSqlQuery(db);
+
+    if (!query.exec(pragma)) {
+      qDebug() << "failed to apply " + pragma.toUtf8() + ": " + query.lastError().text().toUtf8();
+    }
+  }
+}
+
+auto migrate_schema(QSqlDatabase& db) -> bool {
+  auto query = QSqlQuery(db);
+
+  if (!query.exec("pragma user_version") || !query.next()) {
+    qDebug() << "failed to read the schema version";
+
+    return false;
+  }
+
+  const int version = query.value(0).toInt();
+
+  if (version >= schema_version) {
+    return true;
+  }
+
+  qInfo() << "Migrating the database schema from version" << version << "to" << schema_version;
+
+  if (!db.transaction()) {
+    qDebug() << "failed to start the schema migration: " + db.lastError().text().toUtf8();
+
+    return false;
+  }
+
+  // The version is written in the same transaction as the steps, so a step that failed runs again on the next start
+
+  if (!migrate_steps(db, version)) {
+    qDebug() << "the schema migration failed and was rolled back";
+
+    db.rollback();
+
+    return false;
+  }
+
+  if (!query.exec("pragma user_version = " + QString::number(schema_version))) {
+    qDebug() << "failed to write the schema version: " + query.lastError().text().toUtf8();
+
+    db.rollback();
+
+    return false;
+  }
+
+  if (!db.commit()) {
+    qDebug() << "failed to commit the schema migration: " + db.lastError().text().toUtf8();
+
+    db.rollback();
+
+    return false;
+  }
+
+  return true;
+}
+
+auto schema_is_current(const QSqlDatabase& db) -> bool {
+  auto query = QSqlQuery(db);
+
+  if (!query.exec("pragma user_version") || !query.next()) {
+    qDebug() << "failed to read the schema version";
+
+    return false;
+  }
+
+  return query.value(0).toInt() >= schema_version;
+}
+
+auto list_stock_tables(const QSqlDatabase& db) -> QVector<QString> {
+  QVector<QString> names;
+
+  auto query = QSqlQuery(db);
+
+  query.prepare(
+      "select m.name from sqlite_master as m where m.type = 'table' and m.name not like 'sqlite_%'"
+      " and exists (select 1 from pragma_table_info(m.name) where name = 'date')"
+      " and exists (select 1 from pragma_table_info(m.name) where name = 'value')"
+      " and not exists (select 1 from pragma_table_info(m.name) where name = 'instrument_id') order by m.name");
+
+  if (query.exec()) {
+    while (query.next()) {
+      names.append(query.value(0).toString());
+    }
+  } else {
+    qDebug() << "Failed to get table names: " + query.lastError().text().toUtf8();
+  }
+
+  return names;
+}
+
+auto create_stock_table(const QSqlDatabase& db, const QString& name) -> bool {
+  auto query = QSqlQuery(db);
+
+  query.prepare("create table " + name +
+                " (id integer primary key, date int default " + current_msecs + "," +
+                " value real default 0.0, return_perc real default 0.0, accumulated_return_perc real default 0.0)");
+
+  if (!query.exec()) {
+    qDebug() << "Failed to create table " + name.toUtf8() + ". Maybe it already exists.";
+
+    return false;
+  }
+
+  return true;
+}
+
+auto insert_series(QSqlDatabase& db, const QString& table_name, const int& instrument_id, const TimeSeries& series)
+    -> bool {
+  // The series ids are written as the row ids. In the prices table they are the instrument id.
+
+  QVariantList ids;
+  QVariantList dates;
+  QVariantList values;
+  QVariantList return_perc;
+  QVariantList accumulated_return_perc;
+
+  ids.reserve(series.size());
+  dates.reserve(series.size());
+  values.reserve(series.size());
+  return_perc.reserve(series.size());
+  accumulated_return_perc.reserve(series.size());
+
+  for (int n = 0; n < series.size(); n++) {
+    ids.append(series.ids[n]);
+    dates.append(series.dates[n]);
+    values.append(series.values[n]);
+    return_perc.append(series.return_perc[n]);
+    accumulated_return_perc.append(series.accumulated_return_perc[n]);
+  }
+
+  if (!db.transaction()) {
+    qDebug() << db.lastError().text().toUtf8();
+
+    return false;
+  }
+
+  auto query = QSqlQuery(db);
+
+  // The version triggers of the prices table would run once per row. The version is bumped a single time instead.
+
+  if (instrument_id >= 0) {
+    query.exec("drop trigger if exists prices_version_insert");
+
+    query.prepare(
+        "insert or replace into prices (instrument_id, date, value, return_perc, accumulated_return_perc)"
+        " values (?, ?, ?, ?, ?)");
+  } else {
+    query.prepare("insert into " + table_name +
+                  " (id, date, value, return_perc, accumulated_return_perc) values (?, ?, ?, ?, ?)");
+  }
+
+  query.addBindValue(ids);
+  query.addBindValue(dates);
+  query.addBindValue(values);
+  query.addBindValue(return_perc);
+  query.addBindValue(accumulated_return_perc);
+
+  if (!query.execBatch()) {
+    qDebug() << "failed to insert the rows of table " + table_name.toUtf8();
+
+    qDebug() << query.lastError().text().toUtf8();
+
+    db.rollback();
+
+    return false;
+  }
+
+  if (instrument_id >= 0) {
+    create_instrument_version_triggers(db);
+  }
+
+  bump_series_version(db, table_name);
+
+  return db.commit();
+}
+
+auto long_format_enabled(const QSqlDatabase& db) -> bool {
+  return db.tables().contains("instruments") && db.tables().contains("prices");
+}
+
+auto migrate_to_long_format(QSqlDatabase& db) -> bool {
+  // All instruments go to a single prices table clustered by (instrument_id, date). The old per stock tables are
+  // dropped once their rows were copied.
+
+  if (!db.transaction()) {
+    qDebug() << db.lastError().text().toUtf8();
+
+    return false;
+  }
+
+  auto query = QSqlQuery(db);
+
+  const QVector<QString> statements = {
+      "create table if not exists instruments (id integer primary key, name text not null unique)",
+      "create table if not exists prices (instrument_id integer not null,"
+      " date int not null default " + QString(current_msecs) + ", value real default 0.0,"
+      " return_perc real default 0.0, accumulated_return_perc real default 0.0,"
+      " primary key (instrument_id, date)) without rowid",
+      "create table if not exists series_versions (name text primary key, version integer not null default 0)"};
+
+  for (auto& statement : statements) {
+    if (!query.exec(statement)) {
+      qDebug() << query.lastError().text().toUtf8();
+
+      db.rollback();
+
+      return false;
+    }
+  }
+
+  if (!create_instrument_version_triggers(db)) {
+    db.rollback();
+
+    return false;
+  }
+
+  for (auto& name : list_stock_tables(db)) {
+    const int id = add_instrument(db, name);
+
+    if (id < 0) {
+      db.rollback();
+
+      return false;
+    }
+
+    // rows sharing a date keep the last one written
+
+    query.prepare("insert or replace into prices (instrument_id, date, value, return_perc, accumulated_return_perc)"
+                  " select ?, date, value, return_perc, accumulated_return_perc from " +
+                  name + " order by date, id");
+
+    query.addBindValue(id);
+
+    if (!query.exec() || !query.exec("drop table " + name)) {
+      qDebug() << "failed to migrate table " + name.toUtf8() + ": " + query.lastError().text().toUtf8();
+
+      db.rollback();
+
+      return false;
+    }
+
+    qInfo() << "Migrated table: " + name.toUtf8();
+  }
+
+  return db.commit();
+}
+
+auto list_instruments(const QSqlDatabase& db) -> QVector<QPair<int, QString>> {
+  QVector<QPair<int, QString>> instruments;
+
+  auto query = QSqlQuery(db);
+
+  if (query.exec("select id, name from instruments order by name")) {
+    while (query.next()) {
+      instruments.append({query.value(0).toInt(), query.value(1).toString()});
+    }
+  } else {
+    qDebug() << "Failed to get the instruments: " + query.lastError().text().toUtf8();
+  }
+
+  return instruments;
+}
+
+auto add_instrument(const QSqlDatabase& db, const QString& name) -> int {
+  auto query = QSqlQuery(db);
+
+  query.prepare("insert into instruments (name) values (?)");
+
+  query.addBindValue(name);
+
+  if (!query.exec()) {
+    qDebug() << "failed to add instrument " + name.toUtf8() + ": " + query.lastError().text().toUtf8();
+
+    return -1;
+  }
+
+  bump_series_version(db, name);
+
+  return query.lastInsertId().toInt();
+}
+
+auto create_date_index(const QSqlDatabase& db, const QString& table_name) -> bool {
+  auto query = QSqlQuery(db);
+
+  if (!query.exec("create index if not exists " + table_name + "_date_index on " + table_name + " (date)")) {
+    qDebug() << "failed to index table " + table_name.toUtf8() + ": " + query.lastError().text().toUtf8();
+
+    return false;
+  }
+
+  return true;
+}
+
+void drop_date_index(const QSqlDatabase& db, const QString& table_name) {
+  auto query = QSqlQuery(db);
+
+  query.exec("drop index if exists " + table_name + "_date_index");
+}
+
+auto create_version_triggers(const QSqlDatabase& db, const QString& table_name) -> bool {
+  auto query = QSqlQuery(db);
+
+  const QString bump = " begin update series_versions set version = version + 1 where name = '" + table_name + "'; end";
+
+  const QVector<QString> statements = {
+      "create trigger if not exists " + table_name + "_version_insert after insert on " + table_name + bump,
+      "create trigger if not exists " + table_name + "_version_update after update of date, value on " + table_name +
+          bump,
+      "create trigger if not exists " + table_name + "_version_delete after delete on " + table_name + bump};
+
+  for (auto& statement : statements) {
+    if (!query.exec(statement)) {
+      qDebug() << "failed to create the version triggers of table " + table_name.toUtf8() + ": " +
+                      query.lastError().text().toUtf8();
+
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void drop_version_triggers(const QSqlDatabase& db, const QString& table_name) {
+  auto query = QSqlQuery(db);
+
+  for (auto& suffix : {"_version_insert", "_version_update", "_version_delete"}) {
+    query.exec("drop trigger if exists " + table_name + suffix);
+  }
+}
+
+auto bump_series_version(const QSqlDatabase& db, const QString& name) -> bool {
+  // The row of a removed table is kept. A new table reusing its name must not match what was cached for the old one.
+
+  auto query = QSqlQuery(db);
+
+  query.prepare("insert or ignore into series_versions (name) values (?)");
+
+  query.addBindValue(name);
+
+  if (query.exec()) {
+    query.prepare("update series_versions set version = version + 1 where name = ?");
+
+    query.addBindValue(name);
+
+    if (query.exec()) {
+      return true;
+    }
+  }
+
+  qDebug() << "failed to update the version of " + name.toUtf8() + ": " + query.lastError().text().toUtf8();
+
+  return false;
+}
+
+auto read_series_versions(const QSqlDatabase& db) -> QHash<QString, qint64> {
+  QHash<QString, qint64> versions;
+
+  auto query = QSqlQuery(db);
+
+  if (query.exec("select name, version from series_versions")) {
+    while (query.next()) {
+      versions.insert(query.value(0).toString(), query.value(1).toLongLong());
+    }
+  }
+
+  return versions;
+}
+
+auto save_returns(QSqlDatabase& db, const QString& table_name, const TimeSeries& series) -> bool {
+  QVariantList return_perc;
+  QVariantList accumulated_return_perc;
+  QVariantList ids;
+
+  return_perc.reserve(series.size());
+  accumulated_return_perc.reserve(series.size());
+  ids.reserve(series.size());
+
+  for (int n = 0; n < series.size(); n++) {
+    return_perc.append(series.return_perc[n]);
+    accumulated_return_perc.append(series.accumulated_return_perc[n]);
+    ids.append(series.ids[n]);
+  }
+
+  // One transaction and one prepared statement for the whole table
+
+  if (!db.transaction()) {
+    qDebug() << db.lastError().text().toUtf8();
+
+    return false;
+  }
+
+  auto query = QSqlQuery(db);
+
+  query.prepare("update " + table_name + " set return_perc = ?, accumulated_return_perc = ? where id = ?");
+
+  query.addBindValue(return_perc);
+  query.addBindValue(accumulated_return_perc);
+  query.addBindValue(ids);
+
+  if (!query.execBatch()) {
+    qDebug() << "failed to save the returns of table " + table_name.toUtf8();
+
+    qDebug() << query.lastError().text().toUtf8();
+
+    db.rollback();
+
+    return false;
+  }
+
+  return db.commit();
+}
+
+auto save_instrument_returns(QSqlDatabase& db, const int& instrument_id, const TimeSeries& series) -> bool {
+  QVariantList return_perc;
+  QVariantList accumulated_return_perc;
+  QVariantList ids;
+  QVariantList dates;
+
+  return_perc.reserve(series.size());
+  accumulated_return_perc.reserve(series.size());
+  ids.reserve(series.size());
+  dates.reserve(series.size());
+
+  for (int n = 0; n < series.size(); n++) {
+    return_perc.append(series.return_perc[n]);
+    accumulated_return_perc.append(series.accumulated_return_perc[n]);
+    ids.append(instrument_id);
+    dates.append(series.dates[n]);
+  }
+
+  if (!db.transaction()) {
+    qDebug() << db.lastError().text().toUtf8();
+
+    return false;
+  }
+
+  auto query = QSqlQuery(db);
+
+  query.prepare(
+      "update prices set return_perc = ?, accumulated_return_perc = ? where instrument_id = ? and date = ?");
+
+  query.addBindValue(return_perc);
+  query.addBindValue(accumulated_return_perc);
+  query.addBindValue(ids);
+  query.addBindValue(dates);
+
+  if (!query.execBatch()) {
+    qDebug() << "failed to save the returns of instrument " << instrument_id;
+
+    qDebug() << query.lastError().text().toUtf8();
+
+    db.rollback();
+
+    return false;
+  }
+
+  return db.commit();
+}
+
+auto sql_returns_available(const QSqlDatabase& db) -> bool {
+  // UPDATE ... FROM needs SQLite 3.33. The ln and exp functions are optional in SQLite builds.
+
+  auto query = QSqlQuery(db);
+
+  if (!query.exec("select sqlite_version()") || !query.next()) {
+    return false;
+  }
+
+  const auto version = query.value(0).toString().split(".");
+
+  if (version.size() < 2 || version[0].toInt() < 3 || (version[0].toInt() == 3 && version[1].toInt() < 33)) {
+    return false;
+  }
+
+  return query.exec("select exp(sum(ln(1.0)) over ()), lag(1) over ()");
+}
+
+auto values_are_positive(const QSqlDatabase& db, const QString& table_name, const int& instrument_id) -> bool {
+  auto query = QSqlQuery(db);
+
+  if (instrument_id < 0) {
+    query.prepare("select exists (select 1 from " + table_name + " where value <= 0)");
+  } else {
+    query.prepare("select exists (select 1 from prices where instrument_id = ? and value <= 0)");
+
+    query.addBindValue(instrument_id);
+  }
+
+  if (!query.exec() || !query.next()) {
+    qDebug() << "failed to check the values of table " + table_name.toUtf8() + ": " +
+                    query.lastError().text().toUtf8();
+
+    return false;
+  }
+
+  return !query.value(0).toBool();
+}
+
+auto calculate_returns_in_db(QSqlDatabase& db, const QVector<QString>& table_names) -> bool {
+  // The accumulated return is the product of (1 + return) written as the exponential of a running sum of logarithms
+
+  if (!db.transaction()) {
+    qDebug() << db.lastError().text().toUtf8();
+
+    return false;
+  }
+
+  for (auto& name : table_names) {
+    auto query = QSqlQuery(db);
+
+    query.prepare("update " + name +
+                  " set return_perc = r.return_perc, accumulated_return_perc = r.accumulated_return_perc from"
+                  " (select id, return_perc, 100 * (exp(sum(ln(1 + return_perc / 100)) over"
+                  " (order by date, id rows unbounded preceding)) - 1) as accumulated_return_perc from"
+                  " (select id, date, coalesce(100 * (value - lag(value) over w) / lag(value) over w, 0) as return_perc"
+                  " from " +
+                  name + " window w as (order by date, id))) as r where " + name + ".id = r.id");
+
+    if (!query.exec()) {
+      qDebug() << "failed to calculate the returns of table " + name.toUtf8();
+
+      qDebug() << query.lastError().text().toUtf8();
+
+      db.rollback();
+
+      return false;
+    }
+  }
+
+  return db.commit();
+}
+
+auto calculate_instrument_returns_in_db(QSqlDatabase& db, const int& instrument_id) -> bool {
+  // A negative id recalculates every instrument in a single statement
+
+  const QString filter = (instrument_id < 0) ? "" : " where instrument_id = " + QString::number(instrument_id);
+
+  auto query = QSqlQuery(db);
+
+  query.prepare(
+      "update prices set return_perc = r.return_perc, accumulated_return_perc = r.accumulated_return_perc from"
+      " (select instrument_id, date, return_perc, 100 * (exp(sum(ln(1 + return_perc / 100)) over"
+      " (partition by instrument_id order by date rows unbounded preceding)) - 1) as accumulated_return_perc from"
+      " (select instrument_id, date, coalesce(100 * (value - lag(value) over w) / lag(value) over w, 0) as return_perc"
+      " from prices" +
+      filter +
+      " window w as (partition by instrument_id order by date))) as r"
+      " where prices.instrument_id = r.instrument_id and prices.date = r.date");
+
+  if (!query.exec()) {
+    qDebug() << "failed to calculate the returns of the instruments: " + query.lastError().text().toUtf8();
+
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,61 @@
+#ifndef DB_FUNCS_HPP
+#define DB_FUNCS_HPP
+
+#include <QHash>
+#include <QPair>
+#include <QSqlDatabase>
+#include "time_series.hpp"
+
+void apply_storage_profile(const QSqlDatabase& db);
+
+// Brings the schema up to date in a single transaction. Nothing is changed when one of the steps fails.
+
+auto migrate_schema(QSqlDatabase& db) -> bool;
+
+// false when the schema is older than the one migrate_schema() creates or its version could not be read
+
+auto schema_is_current(const QSqlDatabase& db) -> bool;
+
+auto list_stock_tables(const QSqlDatabase& db) -> QVector<QString>;
+
+auto create_stock_table(const QSqlDatabase& db, const QString& name) -> bool;
+
+auto insert_series(QSqlDatabase& db, const QString& table_name, const int& instrument_id, const TimeSeries& series)
+    -> bool;
+
+auto long_format_enabled(const QSqlDatabase& db) -> bool;
+
+auto migrate_to_long_format(QSqlDatabase& db) -> bool;
+
+auto list_instruments(const QSqlDatabase& db) -> QVector<QPair<int, QString>>;
+
+auto add_instrument(const QSqlDatabase& db, const QString& name) -> int;
+
+auto create_date_index(const QSqlDatabase& db, const QString& table_name) -> bool;
+
+void drop_date_index(const QSqlDatabase& db, const QString& table_name);
+
+auto create_version_triggers(const QSqlDatabase& db, const QString& table_name) -> bool;
+
+void drop_version_triggers(const QSqlDatabase& db, const QString& table_name);
+
+auto bump_series_version(const QSqlDatabase& db, const QString& name) -> bool;
+
+auto read_series_versions(const QSqlDatabase& db) -> QHash<QString, qint64>;
+
+auto save_returns(QSqlDatabase& db, const QString& table_name, const TimeSeries& series) -> bool;
+
+auto save_instrument_returns(QSqlDatabase& db, const int& instrument_id, const TimeSeries& series) -> bool;
+
+auto sql_returns_available(const QSqlDatabase& db) -> bool;
+
+// The returns calculated in the database use the logarithm of 1 + return. They only match the ones of
+// percent_returns() and accumulated_return() when every value is positive. A negative instrument_id reads the table.
+
+auto values_are_positive(const QSqlDatabase& db, const QString& table_name, const int& instrument_id) -> bool;
+
+auto calculate_returns_in_db(QSqlDatabase& db, const QVector<QString>& table_names) -> bool;
+
+auto calculate_instrument_returns_in_db(QSqlDatabase& db, const int& instrument_id = -1) -> bool;
+
+#endif
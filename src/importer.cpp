@@ -0,0 +1,157 @@
+#include "importer.hpp"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSqlQuery>
+#include <QThread>
+#include <utility>
+#include "archive_funcs.hpp"
+#include "csv_funcs.hpp"
+#include "db_funcs.hpp"
+#include "math.hpp"
+
+namespace {
+
+const QString connection_name = "importer";
+
+}  // namespace
+
+Importer::Importer(QString database_path, QStringList files)
+    : database_path(std::move(database_path)), files(std::move(files)) {}
+
+void Importer::load() {
+  {
+    auto db = QSqlDatabase::addDatabase("QSQLITE", connection_name);
+
+    db.setDatabaseName(database_path);
+
+    if (db.open()) {
+      apply_storage_profile(db);
+
+      emit started(files.size());
+
+      for (auto& path : files) {
+        if (QThread::currentThread()->isInterruptionRequested()) {
+          break;
+        }
+
+        import_file(db, path);
+      }
+
+      db.close();
+    } else {
+      qCritical("The importer failed to open the database file!");
+    }
+  }
+
+  // the connection can only be removed after every object using it was destroyed
+
+  QSqlDatabase::removeDatabase(connection_name);
+
+  emit finished();
+}
+
+void Importer::import_file(QSqlDatabase& db, const QString& path) {
+  QElapsedTimer timer;
+
+  timer.start();
+
+  // archives written by export_tables() hold many tables that were already calculated
+
+  if (path.endsWith(".stocks", Qt::CaseInsensitive)) {
+    read_archive(path, [&](const QString& name, TimeSeries& series) { import_series(db, name, series); });
+
+    qInfo() << "Imported" << path << "in" << timer.elapsed() << "ms";
+
+    return;
+  }
+
+  TimeSeries series;
+
+  if (!parse_csv(path, series)) {
+    qDebug() << "no rows could be imported from " + path.toUtf8();
+
+    return;
+  }
+
+  series.return_perc = percent_returns(series.values);
+  series.accumulated_return_perc = accumulated_return(series.return_perc);
+
+  import_series(db, QFileInfo(path).completeBaseName(), series);
+
+  qInfo() << "Imported" << series.size() << "rows from" << path << "in" << timer.elapsed() << "ms";
+}
+
+void Importer::import_series(QSqlDatabase& db, const QString& base_name, TimeSeries& series) {
+  const auto name = table_name(db, base_name);
+
+  int instrument_id = -1;
+
+  if (long_format_enabled(db)) {
+    instrument_id = add_instrument(db, name);
+
+    if (instrument_id < 0) {
+      return;
+    }
+
+    series.ids.fill(instrument_id);
+  } else {
+    if (!create_stock_table(db, name)) {
+      return;
+    }
+
+    for (int n = 0; n < series.size(); n++) {
+      series.ids[n] = n + 1;
+    }
+  }
+
+  if (!insert_series(db, name, instrument_id, series)) {
+    auto query = QSqlQuery(db);
+
+    if (instrument_id < 0) {
+      query.exec("drop table if exists " + name);
+    } else {
+      query.exec("delete from instruments where id = " + QString::number(instrument_id));
+    }
+
+    return;
+  }
+
+  // indexing after the rows were inserted is faster than keeping the index updated
+
+  if (instrument_id < 0) {
+    create_date_index(db, name);
+    create_version_triggers(db, name);
+  }
+
+  emit tableReady(name, instrument_id, series);
+}
+
+auto Importer::table_name(const QSqlDatabase& db, const QString& base_name) -> QString {
+  // The name is turned into a valid table name that is not in use yet
+
+  auto base = base_name.toLower();
+
+  base.replace(QRegularExpression("[^a-z0-9_]"), "_");
+
+  if (base.isEmpty() || base[0].isDigit()) {
+    base.prepend("stock_");
+  }
+
+  QStringList used = db.tables();
+
+  if (long_format_enabled(db)) {
+    for (auto& instrument : list_instruments(db)) {
+      used.append(instrument.second);
+    }
+  }
+
+  auto name = base;
+
+  for (int n = 2; used.contains(name, Qt::CaseInsensitive); n++) {
+    name = base + "_" + QString::number(n);
+  }
+
+  return name;
+}
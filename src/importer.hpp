@@ -0,0 +1,36 @@
+#ifndef IMPORTER_HPP
+#define IMPORTER_HPP
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QStringList>
+#include "time_series.hpp"
+
+// Imports csv files and archives in a worker thread using its own database connection. Every csv file and every table
+// of an archive becomes a new table, or a new instrument when the single table storage is in use, and is handed to the
+// gui thread already calculated.
+
+class Importer : public QObject {
+  Q_OBJECT
+ public:
+  Importer(QString database_path, QStringList files);
+
+  void load();
+
+ signals:
+  void started(int count);
+  void tableReady(const QString& name, int instrument_id, const TimeSeries& series);
+  void finished();
+
+ private:
+  QString database_path;
+
+  QStringList files;
+
+  void import_file(QSqlDatabase& db, const QString& path);
+  void import_series(QSqlDatabase& db, const QString& base_name, TimeSeries& series);
+
+  static auto table_name(const QSqlDatabase& db, const QString& base_name) -> QString;
+};
+
+#endif
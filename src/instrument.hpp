@@ -0,0 +1,18 @@
+#ifndef INSTRUMENT_HPP
+#define INSTRUMENT_HPP
+
+#include <QString>
+#include "time_series.hpp"
+
+// What the application keeps in memory for every stock. The table editor and its model only exist for the selected
+// one.
+
+struct Instrument {
+  QString name;
+
+  int instrument_id = -1;  // row of the instruments table when all prices are stored in a single table
+
+  TimeSeries series;
+};
+
+#endif
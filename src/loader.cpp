@@ -0,0 +1,206 @@
+#include "loader.hpp"
+#include <QDebug>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <utility>
+#include "db_funcs.hpp"
+#include "math.hpp"
+#include "series_cache.hpp"
+
+namespace {
+
+const QString connection_name = "loader";
+
+}  // namespace
+
+Loader::Loader(QString database_path, const bool& calculate_in_db, const bool& read_only)
+    : database_path(std::move(database_path)), calculate_in_db(calculate_in_db && !read_only), read_only(read_only) {}
+
+void Loader::load() {
+  {
+    auto db = QSqlDatabase::addDatabase("QSQLITE", connection_name);
+
+    db.setDatabaseName(database_path);
+
+    if (read_only) {
+      db.setConnectOptions("QSQLITE_OPEN_READONLY");
+    }
+
+    if (db.open()) {
+      // the profile switches the journal mode, which writes to the file
+
+      if (!read_only) {
+        apply_storage_profile(db);
+      }
+
+      load_tables(db);
+
+      db.close();
+    } else {
+      qCritical("The loader failed to open the database file!");
+    }
+  }
+
+  // the connection can only be removed after every object using it was destroyed
+
+  QSqlDatabase::removeDatabase(connection_name);
+
+  emit finished();
+}
+
+void Loader::load_tables(QSqlDatabase& db) {
+  QVector<QPair<int, QString>> tables;
+
+  const bool long_format = long_format_enabled(db);
+
+  if (long_format) {
+    tables = list_instruments(db);
+  } else {
+    for (auto& name : list_stock_tables(db)) {
+      tables.append({-1, name});
+    }
+  }
+
+  emit started(tables.size());
+
+  // Tables whose rows did not change since the last run are taken from the cache and are not calculated again
+
+  const auto versions = read_series_versions(db);
+
+  // The cache is named after the database. Its entries are only keyed by table name and version, so databases in the
+  // same folder must not share it.
+
+  SeriesCache cache(QFileInfo(database_path).absoluteFilePath() + ".series.cache");
+
+  QHash<QString, TimeSeries> cached;
+
+  QVector<QPair<int, QString>> outdated;
+
+  for (auto& table : tables) {
+    TimeSeries series;
+
+    if (versions.contains(table.second) && cache.find(table.second, versions[table.second], series)) {
+      cached.insert(table.second, series);
+    } else {
+      outdated.append(table);
+    }
+  }
+
+  qInfo() << "Tables found in the series cache:" << cached.size() << "of" << tables.size();
+
+  // A value that is zero or negative makes the logarithms used by the database undefined. Those tables get their
+  // returns from percent_returns() like when the database does not calculate them.
+
+  QVector<QPair<int, QString>> in_db;
+
+  QSet<QString> in_db_names;
+
+  if (calculate_in_db) {
+    for (auto& table : outdated) {
+      if (values_are_positive(db, table.second, table.first)) {
+        in_db.append(table);
+
+        in_db_names.insert(table.second);
+      }
+    }
+  }
+
+  bool calculated = false;
+
+  if (!in_db.empty()) {
+    if (long_format) {
+      if (in_db.size() == tables.size()) {
+        calculated = calculate_instrument_returns_in_db(db);
+      } else {
+        calculated = true;
+
+        for (auto& table : in_db) {
+          calculated = calculate_instrument_returns_in_db(db, table.first) && calculated;
+        }
+      }
+    } else {
+      QVector<QString> names;
+
+      for (auto& table : in_db) {
+        names.append(table.second);
+      }
+
+      calculated = calculate_returns_in_db(db, names);
+    }
+  }
+
+  for (auto& [id, name] : tables) {
+    if (QThread::currentThread()->isInterruptionRequested()) {
+      return;
+    }
+
+    TimeSeries series;
+
+    if (cached.contains(name)) {
+      series = cached.take(name);
+    } else {
+      series = read_series(db, name, id);
+
+      if ((!calculated || !in_db_names.contains(name)) && !series.empty()) {
+        series.return_perc = percent_returns(series.values);
+        series.accumulated_return_perc = accumulated_return(series.return_perc);
+
+        if (!read_only && long_format) {
+          save_instrument_returns(db, id, series);
+        } else if (!read_only) {
+          save_returns(db, name, series);
+        }
+      }
+    }
+
+    // writing the returns does not change the version of a table
+
+    if (versions.contains(name)) {
+      cache.insert(name, versions[name], series);
+    }
+
+    emit tableReady(name, id, series);
+  }
+
+  if (!read_only) {
+    cache.save();
+  }
+}
+
+auto Loader::read_series(const QSqlDatabase& db, const QString& name, const int& instrument_id) -> TimeSeries {
+  TimeSeries series;
+
+  auto query = QSqlQuery(db);
+
+  query.setForwardOnly(true);
+
+  if (instrument_id < 0) {
+    query.prepare("select id, date, value, return_perc, accumulated_return_perc from " + name + " order by date, id");
+  } else {
+    query.prepare(
+        "select instrument_id, date, value, return_perc, accumulated_return_perc from prices where instrument_id = ?"
+        " order by date");
+
+    query.addBindValue(instrument_id);
+  }
+
+  if (!query.exec()) {
+    qDebug() << "failed to read table " + name.toUtf8() + ": " + query.lastError().text().toUtf8();
+
+    return series;
+  }
+
+  while (query.next()) {
+    series.ids.append(query.value(0).toLongLong());
+    series.dates.append(query.value(1).toLongLong());
+    series.values.append(query.value(2).toDouble());
+    series.return_perc.append(query.value(3).toDouble());
+    series.accumulated_return_perc.append(query.value(4).toDouble());
+  }
+
+  return series;
+}
@@ -0,0 +1,36 @@
+#ifndef LOADER_HPP
+#define LOADER_HPP
+
+#include <QObject>
+#include <QSqlDatabase>
+#include "time_series.hpp"
+
+// Reads and calculates the saved tables in a worker thread using its own database connection. Each table is handed
+// to the gui thread as soon as it is ready. In read only mode the database is opened read only, and neither the
+// returns nor the series cache are written back.
+
+class Loader : public QObject {
+  Q_OBJECT
+ public:
+  Loader(QString database_path, const bool& calculate_in_db, const bool& read_only = false);
+
+  void load();
+
+ signals:
+  void started(int count);
+  void tableReady(const QString& name, int instrument_id, const TimeSeries& series);
+  void finished();
+
+ private:
+  QString database_path;
+
+  bool calculate_in_db;
+
+  bool read_only;
+
+  void load_tables(QSqlDatabase& db);
+
+  static auto read_series(const QSqlDatabase& db, const QString& name, const int& instrument_id) -> TimeSeries;
+};
+
+#endif
@@ -1,12 +1,136 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cstring>
 #include "main_window.hpp"
+#include "report_funcs.hpp"
+
+namespace {
+
+// Reads the options of the report mode. Returns false after printing the problem when one of them is invalid.
+
+auto parse_report_options(const QCommandLineParser& parser, ReportOptions& options) -> bool {
+  options.output_dir = parser.value("report");
+
+  options.database_path = parser.isSet("database")
+                              ? parser.value("database")
+                              : QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/stocks.sqlite";
+
+  options.format = parser.value("format").toLower();
+
+  if (options.format != "png" && options.format != "pdf") {
+    qCritical() << "Unknown report format:" << options.format;
+
+    return false;
+  }
+
+  if (parser.isSet("size")) {
+    const auto parts = parser.value("size").split('x');
+
+    const int width = parts.value(0).toInt();
+    const int height = parts.value(1).toInt();
+
+    if (parts.size() != 2 || width <= 0 || height <= 0) {
+      qCritical() << "The size must be given as WIDTHxHEIGHT:" << parser.value("size");
+
+      return false;
+    }
+
+    options.size = QSize(width, height);
+  }
+
+  if (parser.isSet("frequency")) {
+    const auto names = frequency_names();
+
+    const auto it = std::find_if(names.begin(), names.end(), [&](const QString& name) {
+      return name.compare(parser.value("frequency"), Qt::CaseInsensitive) == 0;
+    });
+
+    if (it == names.end()) {
+      qCritical() << "The frequency must be one of" << names;
+
+      return false;
+    }
+
+    options.frequency = Frequency(it - names.begin());
+  }
+
+  const auto read_count = [&](const QString& name, int& value) {
+    if (!parser.isSet(name)) {
+      return true;
+    }
+
+    bool ok = false;
+
+    value = parser.value(name).toInt(&ok);
+
+    if (!ok || value < 0) {
+      qCritical() << "Invalid value for" << name << ":" << parser.value(name);
+
+      return false;
+    }
+
+    return true;
+  };
+
+  if (!read_count("days", options.days) || !read_count("months", options.months) ||
+      !read_count("window", options.window)) {
+    return false;
+  }
+
+  options.fund = parser.value("fund");
+
+  return true;
+}
+
+}  // namespace
 
 auto main(int argc, char* argv[]) -> int {
+  // the report mode does not need a display
+
+  const bool report =
+      std::any_of(argv + 1, argv + argc, [](const char* arg) { return std::strncmp(arg, "--report", 8) == 0; });
+
+  if (report && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+
   QApplication app(argc, argv);
 
   QCoreApplication::setOrganizationName("wwmm");
   QCoreApplication::setApplicationName("Stocks");
 
+  QCommandLineParser parser;
+
+  parser.setApplicationDescription("A simple program that helps to compare stocks.");
+  parser.addHelpOption();
+
+  parser.addOptions({
+      {"report", "Write the charts of every table and of the analyses to <folder> and exit.", "folder"},
+      {"database", "Database file of the report. The one used by the program by default.", "file"},
+      {"format", "File format of the report: png or pdf.", "format", "png"},
+      {"size", "Size of the report charts in pixels.", "WIDTHxHEIGHT"},
+      {"frequency", "Frequency of the report analyses: raw, weekly, monthly, quarterly or yearly.", "frequency"},
+      {"days", "Rows of the report return charts.", "days"},
+      {"months", "Rows of the report correlation and pca.", "rows"},
+      {"window", "Rolling window of the report volatility and correlation. 0 or 1 uses all the rows.", "rows"},
+      {"fund", "Table the report correlation is calculated against. The first one by default.", "name"},
+  });
+
+  parser.process(app);
+
+  if (parser.isSet("report")) {
+    ReportOptions options;
+
+    if (!parse_report_options(parser, options)) {
+      return 1;
+    }
+
+    return write_report(options) ? 0 : 1;
+  }
+
   auto mw = MainWindow();
 
   return QApplication::exec();
@@ -1,13 +1,18 @@
 #include "main_window.hpp"
 #include <QCoreApplication>
 #include <QDir>
+#include <QFileDialog>
+#include <QMenu>
 #include <QSqlError>
-#include <QSqlRecord>
 #include <QStandardPaths>
+#include <QStatusBar>
+#include <QThread>
+#include "archive_funcs.hpp"
+#include "db_funcs.hpp"
 #include "effects.hpp"
 #include "table.hpp"
 
-MainWindow::MainWindow(QMainWindow* parent) : QMainWindow(parent) {
+MainWindow::MainWindow(QMainWindow* parent) : QMainWindow(parent), editor(new Table()) {
   setupUi(this);
 
   tab_widget->setCurrentIndex(0);
@@ -21,6 +26,9 @@ MainWindow::MainWindow(QMainWindow* parent) : QMainWindow(parent) {
   button_save_table->setGraphicsEffect(button_shadow());
   button_calculate_table->setGraphicsEffect(button_shadow());
   button_run_analysis->setGraphicsEffect(button_shadow());
+  button_long_format->setGraphicsEffect(button_shadow());
+  button_import_table->setGraphicsEffect(button_shadow());
+  button_export_table->setGraphicsEffect(button_shadow());
 
   button_database_file->setGraphicsEffect(button_shadow());
 
@@ -31,12 +39,25 @@ MainWindow::MainWindow(QMainWindow* parent) : QMainWindow(parent) {
   connect(button_clear_table, &QPushButton::clicked, this, &MainWindow::on_clear_table);
   connect(button_save_table, &QPushButton::clicked, this, &MainWindow::on_save_table);
   connect(button_run_analysis, &QPushButton::clicked, this, &MainWindow::on_run_analysis);
+  connect(button_long_format, &QPushButton::clicked, this, &MainWindow::on_long_format);
 
-  connect(button_calculate_table, &QPushButton::clicked, this, [&]() {
-    auto table = dynamic_cast<Table*>(stackedwidget_stocks->widget(stackedwidget_stocks->currentIndex()));
+  // import and export menus
 
-    table->calculate();
-  });
+  auto menu_import = new QMenu(this);
+
+  connect(menu_import->addAction("CSV Folder"), &QAction::triggered, this, [&]() { on_import(false); });
+  connect(menu_import->addAction("Archive"), &QAction::triggered, this, [&]() { on_import(true); });
+
+  button_import_table->setMenu(menu_import);
+
+  auto menu_export = new QMenu(this);
+
+  connect(menu_export->addAction("Selected Table"), &QAction::triggered, this, [&]() { on_export(false); });
+  connect(menu_export->addAction("All Tables"), &QAction::triggered, this, [&]() { on_export(true); });
+
+  button_export_table->setMenu(menu_export);
+
+  connect(button_calculate_table, &QPushButton::clicked, this, [&]() { editor->calculate(); });
 
   connect(button_database_file, &QPushButton::clicked, this, [&]() {
     auto path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
@@ -46,12 +67,42 @@ MainWindow::MainWindow(QMainWindow* parent) : QMainWindow(parent) {
   connect(listwidget_analysis, &QListWidget::currentRowChanged, this,
           [&](int currentRow) { stackedwidget_analysis->setCurrentIndex(currentRow); });
 
-  connect(listwidget_tables_stocks, &QListWidget::currentRowChanged, this,
-          [&](int currentRow) { stackedwidget_stocks->setCurrentIndex(currentRow); });
+  connect(listwidget_tables_stocks, &QListWidget::currentRowChanged, this, [&](int currentRow) {
+    if (bind_editor(currentRow >= 0 ? instruments[currentRow].get() : nullptr)) {
+      return;
+    }
+
+    // the editor kept the previous table, so the selection goes back to it
+
+    for (size_t n = 0; n < instruments.size(); n++) {
+      if (instruments[n].get() == editor->instrument) {
+        listwidget_tables_stocks->blockSignals(true);
+
+        listwidget_tables_stocks->setCurrentRow(int(n));
+
+        listwidget_tables_stocks->blockSignals(false);
+
+        break;
+      }
+    }
+  });
   connect(listwidget_tables_stocks, &QListWidget::itemChanged, this, [&](QListWidgetItem* item) {
     on_listwidget_item_changed(item, listwidget_tables_stocks, stackedwidget_stocks);
   });
 
+  // a single editor is bound to the selected table
+
+  stackedwidget_stocks->addWidget(editor);
+
+  // progress of the table loading
+
+  progressbar_loading = new QProgressBar();
+
+  progressbar_loading->setFormat("Loading tables %v/%m");
+  progressbar_loading->hide();
+
+  statusBar()->addPermanentWidget(progressbar_loading);
+
   // apply custom stylesheet
 
   QFile styleFile(":/custom.css");
@@ -86,25 +137,39 @@ MainWindow::MainWindow(QMainWindow* parent) : QMainWindow(parent) {
     if (db.open()) {
       qDebug("The database file was opened!");
 
-      load_saved_tables();
+      apply_storage_profile(db);
 
-      auto tables = QVector<Table const*>();
+      if (!migrate_schema(db)) {
+        qCritical("The database schema could not be updated. The tables may not be read correctly!");
+      }
 
-      for (int n = 0; n < stackedwidget_stocks->count(); n++) {
-        tables.append(dynamic_cast<Table const*>(stackedwidget_stocks->widget(n)));
+      editor->set_database(db);
+
+      if (sql_returns_available(db)) {
+        checkbox_sql_engine->setChecked(qsettings.value("calculate_in_db", false).toBool());
+      } else {
+        checkbox_sql_engine->setEnabled(false);
+        checkbox_sql_engine->setToolTip("The SQLite library does not support the required window and math functions");
       }
 
-      auto compare = load_compare();
-      auto correlation = load_correlation();
-      auto pca = load_pca();
+      editor->calculate_in_db = checkbox_sql_engine->isChecked();
+
+      connect(checkbox_sql_engine, &QCheckBox::toggled, this, [&](bool state) {
+        qsettings.setValue("calculate_in_db", state);
+
+        editor->calculate_in_db = state;
+      });
+
+      load_compare();
+      load_correlation();
+      load_pca();
+      load_correlation_matrix();
 
       listwidget_analysis->setCurrentRow(0);
 
-      // This has to be done after loading the other tables
+      // The tables are read in a worker thread. The analysis runs after the last one arrives.
 
-      compare->process(tables);
-      correlation->process(tables);
-      pca->process(tables);
+      start_loading();
     } else {
       qCritical("Failed to open the database file!");
     }
@@ -113,8 +178,16 @@ MainWindow::MainWindow(QMainWindow* parent) : QMainWindow(parent) {
   show();
 }
 
+MainWindow::~MainWindow() {
+  if (worker_thread != nullptr) {
+    worker_thread->requestInterruption();
+    worker_thread->quit();
+    worker_thread->wait();
+  }
+}
+
 auto MainWindow::load_compare() -> Compare* {
-  auto c = new Compare(db);
+  auto c = new Compare(db, &resampler);
 
   stackedwidget_analysis->addWidget(c);
 
@@ -124,7 +197,7 @@ auto MainWindow::load_compare() -> Compare* {
 }
 
 auto MainWindow::load_correlation() -> Correlation* {
-  auto c = new Correlation(db);
+  auto c = new Correlation(db, &resampler);
 
   stackedwidget_analysis->addWidget(c);
 
@@ -134,7 +207,7 @@ auto MainWindow::load_correlation() -> Correlation* {
 }
 
 auto MainWindow::load_pca() -> PCA* {
-  auto pca = new PCA(db);
+  auto pca = new PCA(db, &resampler);
 
   stackedwidget_analysis->addWidget(pca);
 
@@ -143,90 +216,290 @@ auto MainWindow::load_pca() -> PCA* {
   return pca;
 }
 
-void MainWindow::add_table() {
-  auto name = QString("stock%1").arg(stackedwidget_stocks->count());
+auto MainWindow::load_correlation_matrix() -> CorrelationMatrix* {
+  auto c = new CorrelationMatrix(db);
+
+  stackedwidget_analysis->addWidget(c);
+
+  listwidget_analysis->addItem("Correlation Matrix");
 
-  auto query = QSqlQuery(db);
+  return c;
+}
 
-  query.prepare("create table " + name +
-                " (id integer primary key, date int default (cast(strftime('%s','now') as int))," +
-                " value real default 0.0, return_perc real default 0.0, accumulated_return_perc real default 0.0)");
+void MainWindow::add_table() {
+  auto name = QString("stock%1").arg(instruments.size());
 
-  if (query.exec()) {
-    load_table<Table>(name, stackedwidget_stocks, listwidget_tables_stocks);
+  int instrument_id = -1;
 
-    stackedwidget_stocks->setCurrentIndex(stackedwidget_stocks->count() - 1);
+  if (long_format_enabled(db)) {
+    instrument_id = add_instrument(db, name);
 
-    listwidget_tables_stocks->setCurrentRow(listwidget_tables_stocks->count() - 1);
+    if (instrument_id < 0) {
+      return;
+    }
   } else {
-    qDebug() << "Failed to create table " + name.toUtf8() + ". Maybe it already exists.";
+    if (!create_stock_table(db, name)) {
+      return;
+    }
+
+    create_date_index(db, name);
+    create_version_triggers(db, name);
+
+    bump_series_version(db, name);
   }
+
+  load_instrument(name, instrument_id, TimeSeries());
+
+  listwidget_tables_stocks->setCurrentRow(listwidget_tables_stocks->count() - 1);
 }
 
-void MainWindow::load_saved_tables() {
-  auto query = QSqlQuery(db);
+void MainWindow::load_instrument(const QString& name, const int& instrument_id, const TimeSeries& series) {
+  auto instrument = std::make_unique<Instrument>();
 
-  query.prepare("select name from sqlite_master where type='table'");
+  instrument->name = name;
+  instrument->instrument_id = instrument_id;
+  instrument->series = series;
 
-  if (query.exec()) {
-    auto names = QVector<QString>();
+  instruments.push_back(std::move(instrument));
 
-    while (query.next()) {
-      auto name = query.value(0).toString();
+  listwidget_tables_stocks->addItem(name);
 
-      names.append(name);
-    }
+  auto added_item = listwidget_tables_stocks->item(listwidget_tables_stocks->count() - 1);
 
-    std::sort(names.begin(), names.end());
+  added_item->setFlags(added_item->flags() | Qt::ItemIsEditable);
+}
 
-    auto stocks = QVector<QString>();
+void MainWindow::start_loading() {
+  button_long_format->setEnabled(!long_format_enabled(db));
 
-    for (auto& name : names) {
-      qInfo() << "Found table: " + name.toUtf8();
+  start_worker(new Loader(db.databaseName(), checkbox_sql_engine->isChecked()));
+}
+
+void MainWindow::on_import(const bool& archive) {
+  if (worker_thread != nullptr) {
+    return;
+  }
 
-      auto query = QSqlQuery(db);
+  QStringList files;
 
-      query.prepare("select * from " + name);
+  if (archive) {
+    files = QFileDialog::getOpenFileNames(this, "Import Archives", QString(), "Stocks Archive (*.stocks)");
+  } else {
+    auto dir = QFileDialog::getExistingDirectory(this, "Import CSV Files");
 
-      if (query.exec()) {
-        stocks.append(name);
-      }
+    if (dir.isEmpty()) {
+      return;
     }
 
-    for (auto& name : stocks) {
-      load_table<Table>(name, stackedwidget_stocks, listwidget_tables_stocks);
+    for (auto& info : QDir(dir).entryInfoList({"*.csv", "*.CSV"}, QDir::Files, QDir::Name)) {
+      files.append(info.absoluteFilePath());
     }
+  }
+
+  if (!files.empty()) {
+    start_worker(new Importer(db.databaseName(), files));
+  }
+}
+
+void MainWindow::on_export(const bool& all) {
+  if (worker_thread != nullptr) {
+    return;
+  }
 
-    for (int n = 0; n < stackedwidget_stocks->count(); n++) {
-      auto table = dynamic_cast<Table*>(stackedwidget_stocks->widget(n));
+  QVector<QPair<int, QString>> tables;
 
-      table->calculate();
+  if (all) {
+    for (auto& instrument : instruments) {
+      tables.append({instrument->instrument_id, instrument->name});
     }
+  } else if (editor->instrument != nullptr) {
+    tables.append({editor->instrument->instrument_id, editor->instrument->name});
+  }
+
+  if (tables.empty()) {
+    return;
+  }
+
+  auto path = QFileDialog::getSaveFileName(this, "Export Tables", (all ? "stocks" : tables[0].second) + ".stocks",
+                                           "Stocks Archive (*.stocks)");
+
+  if (path.isEmpty()) {
+    return;
+  }
+
+  if (!path.endsWith(".stocks")) {
+    path += ".stocks";
+  }
+
+  // the archive has to see the edits that were not saved yet
+
+  if (editor->model != nullptr && editor->model->isDirty()) {
+    editor->model->submitAll();
+  }
+
+  auto exported = std::make_shared<bool>(false);
+
+  worker_thread = QThread::create([=, database_path = db.databaseName()]() {
+    {
+      auto export_db = QSqlDatabase::addDatabase("QSQLITE", "exporter");
 
-    if (listwidget_tables_stocks->count() > 0) {
-      listwidget_tables_stocks->setCurrentRow(0);
+      export_db.setDatabaseName(database_path);
+
+      if (export_db.open()) {
+        apply_storage_profile(export_db);
+
+        *exported = export_tables(export_db, tables, path);
+
+        export_db.close();
+      }
     }
-  } else {
-    qDebug("Failed to get table names!");
+
+    QSqlDatabase::removeDatabase("exporter");
+  });
+
+  connect(worker_thread, &QThread::finished, this, [=]() {
+    worker_thread->deleteLater();
+    worker_thread = nullptr;
+
+    statusBar()->showMessage(*exported ? "Exported to " + path : "Failed to export to " + path, 5000);
+  });
+
+  statusBar()->showMessage("Exporting to " + path);
+
+  worker_thread->start();
+}
+
+void MainWindow::on_table_ready(const QString& name, int instrument_id, const TimeSeries& series) {
+  load_instrument(name, instrument_id, series);
+
+  progressbar_loading->setValue(progressbar_loading->value() + 1);
+
+  // the editor is only bound to the first table. The others are bound when selected.
+
+  if (listwidget_tables_stocks->count() == 1) {
+    listwidget_tables_stocks->setCurrentRow(0);
   }
 }
 
+auto MainWindow::bind_editor(Instrument* instrument) -> bool {
+  if (editor->bind(instrument)) {
+    return true;
+  }
+
+  auto box = QMessageBox(this);
+
+  box.setText("The changes to the table " + editor->instrument->name + " could not be saved.");
+  box.setInformativeText("Discard them?");
+  box.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+  box.setDefaultButton(QMessageBox::No);
+
+  if (box.exec() != QMessageBox::Yes) {
+    return false;
+  }
+
+  if (!editor->bind(instrument, true)) {
+    return false;
+  }
+
+  // the analyses may still show the discarded values. There is nothing to show again when the tables are unloaded.
+
+  if (instrument != nullptr) {
+    on_run_analysis();
+  }
+
+  return true;
+}
+
+auto MainWindow::unload_tables() -> bool {
+  if (!bind_editor(nullptr)) {
+    return false;
+  }
+
+  listwidget_tables_stocks->blockSignals(true);
+
+  listwidget_tables_stocks->clear();
+
+  listwidget_tables_stocks->blockSignals(false);
+
+  instruments.clear();
+
+  resampler.clear();
+
+  return true;
+}
+
+void MainWindow::on_long_format() {
+  if (worker_thread != nullptr) {
+    return;
+  }
+
+  auto box = QMessageBox(this);
+
+  box.setText("Move every table to a single prices table?");
+  box.setInformativeText("Rows sharing the same date in a table are merged. This action cannot be undone!");
+  box.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+  box.setDefaultButton(QMessageBox::No);
+
+  if (box.exec() != QMessageBox::Yes) {
+    return;
+  }
+
+  // the editor model must not hold the old tables while they are dropped
+
+  if (!unload_tables()) {
+    return;
+  }
+
+  on_run_analysis();
+
+  if (!migrate_to_long_format(db)) {
+    qCritical("Failed to migrate the tables!");
+  }
+
+  start_loading();
+}
+
 void MainWindow::on_listwidget_item_changed(QListWidgetItem* item, QListWidget* lw, QStackedWidget* sw) {
   if (item == lw->currentItem()) {
     QString new_name = item->text();
 
     auto table = dynamic_cast<Table*>(sw->widget(sw->currentIndex()));
 
+    auto instrument = table->instrument;
+
+    if (instrument == nullptr) {
+      return;
+    }
+
     // finish any pending operation before changing the table name
 
     table->model->submitAll();
 
     auto query = QSqlQuery(db);
 
-    query.prepare("alter table " + table->name + " rename to " + new_name);
+    if (instrument->instrument_id < 0) {
+      query.prepare("alter table " + instrument->name + " rename to " + new_name);
+    } else {
+      query.prepare("update instruments set name = ? where id = ?");
+
+      query.addBindValue(new_name);
+      query.addBindValue(instrument->instrument_id);
+    }
 
     if (query.exec()) {
-      table->name = new_name;
+      if (instrument->instrument_id < 0) {
+        drop_date_index(db, instrument->name);
+        drop_version_triggers(db, instrument->name);
+
+        create_date_index(db, new_name);
+        create_version_triggers(db, new_name);
+      }
+
+      bump_series_version(db, new_name);
+
+      resampler.remove(instrument->name);
+
+      instrument->name = new_name;
 
       lw->currentItem()->setText(new_name.toUpper());
 
@@ -235,12 +508,18 @@ void MainWindow::on_listwidget_item_changed(QListWidgetItem* item, QListWidget*
       table->set_chart1_title(new_name);
       table->set_chart2_title(new_name);
     } else {
-      qDebug() << "failed to rename table " + table->name.toUtf8();
+      qDebug() << "failed to rename table " + instrument->name.toUtf8();
     }
   }
 }
 
 void MainWindow::remove_table(QListWidget* lw, QStackedWidget* sw) {
+  const int row = lw->currentRow();
+
+  if (row < 0) {
+    return;
+  }
+
   auto box = QMessageBox(this);
 
   box.setText("Remove the selected table from the database?");
@@ -253,13 +532,31 @@ void MainWindow::remove_table(QListWidget* lw, QStackedWidget* sw) {
   if (r == QMessageBox::Yes) {
     auto table = dynamic_cast<Table*>(sw->widget(sw->currentIndex()));
 
-    sw->removeWidget(sw->widget(sw->currentIndex()));
+    // the instrument is taken out before the list selects another one
+
+    auto instrument = std::move(instruments[row]);
+
+    instruments.erase(instruments.begin() + row);
+
+    resampler.remove(instrument->name);
 
-    auto it = lw->takeItem(lw->currentRow());
+    // the edits of a table being removed do not matter
+
+    table->bind(nullptr, true);
+
+    lw->blockSignals(true);
+
+    auto it = lw->takeItem(row);
 
     delete it;
 
-    qsettings.beginGroup(table->name);
+    lw->blockSignals(false);
+
+    if (lw->currentRow() >= 0) {
+      table->bind(instruments[lw->currentRow()].get());
+    }
+
+    qsettings.beginGroup(instrument->name);
 
     qsettings.remove("");
 
@@ -267,11 +564,32 @@ void MainWindow::remove_table(QListWidget* lw, QStackedWidget* sw) {
 
     auto query = QSqlQuery(db);
 
-    query.prepare("drop table if exists " + table->name);
+    bool removed = false;
+
+    if (instrument->instrument_id < 0) {
+      removed = query.exec("drop table if exists " + instrument->name);
+    } else {
+      db.transaction();
+
+      const auto id = QString::number(instrument->instrument_id);
+
+      removed = query.exec("delete from prices where instrument_id = " + id) &&
+                query.exec("delete from instruments where id = " + id);
 
-    if (!query.exec()) {
-      qDebug() << "Failed remove table " + table->name.toUtf8() + ". Maybe has already been removed.";
+      if (removed) {
+        db.commit();
+      } else {
+        db.rollback();
+      }
     }
+
+    if (!removed) {
+      qDebug() << "Failed remove table " + instrument->name.toUtf8() + ". Maybe has already been removed.";
+    }
+
+    // the analysis pages must not keep a pointer to the removed instrument
+
+    on_run_analysis();
   }
 }
 
@@ -280,7 +598,9 @@ void MainWindow::on_remove_table() {
 }
 
 void MainWindow::clear_table(const QStackedWidget* sw) {
-  if (sw->count() < 1) {
+  auto table = dynamic_cast<Table*>(sw->widget(sw->currentIndex()));
+
+  if (table->instrument == nullptr) {
     return;
   }
 
@@ -293,15 +613,19 @@ void MainWindow::clear_table(const QStackedWidget* sw) {
   auto r = box.exec();
 
   if (r == QMessageBox::Yes) {
-    auto table = dynamic_cast<Table*>(sw->widget(sw->currentIndex()));
-
     auto query = QSqlQuery(db);
 
-    query.prepare("delete from " + table->name);
+    if (table->instrument->instrument_id < 0) {
+      query.prepare("delete from " + table->instrument->name);
+    } else {
+      query.prepare("delete from prices where instrument_id = " + QString::number(table->instrument->instrument_id));
+    }
 
     if (query.exec()) {
       table->model->select();
 
+      table->update_series();
+
       table->clear_charts();
     } else {
       qDebug() << table->model->lastError().text().toUtf8();
@@ -316,11 +640,11 @@ void MainWindow::on_clear_table() {
 void MainWindow::save_table(const QStackedWidget* sw) {
   auto table = dynamic_cast<Table*>(sw->widget(sw->currentIndex()));
 
-  if (!table->model->submitAll()) {
-    qDebug() << "failed to save table " + table->name.toUtf8() + " to the database";
-
-    qDebug() << table->model->lastError().text().toUtf8();
+  if (table->instrument == nullptr) {
+    return;
   }
+
+  table->save();
 }
 
 void MainWindow::on_save_table() {
@@ -328,10 +652,10 @@ void MainWindow::on_save_table() {
 }
 
 void MainWindow::on_run_analysis() {
-  auto tables = QVector<Table const*>();
+  auto tables = QVector<Instrument const*>();
 
-  for (int n = 0; n < stackedwidget_stocks->count(); n++) {
-    tables.append(dynamic_cast<Table const*>(stackedwidget_stocks->widget(n)));
+  for (auto& instrument : instruments) {
+    tables.append(instrument.get());
   }
 
   auto compare = dynamic_cast<Compare*>(stackedwidget_analysis->widget(0));
@@ -345,4 +669,8 @@ void MainWindow::on_run_analysis() {
   auto pca = dynamic_cast<PCA*>(stackedwidget_analysis->widget(2));
 
   pca->process(tables);
+
+  auto correlation_matrix = dynamic_cast<CorrelationMatrix*>(stackedwidget_analysis->widget(3));
+
+  correlation_matrix->process(tables);
 }
\ No newline at end of file
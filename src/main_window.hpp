@@ -2,30 +2,57 @@
 #define MAIN_WINDOW_HPP
 
 #include <QMainWindow>
+#include <QProgressBar>
 #include <QSettings>
 #include <QSqlDatabase>
 #include <QSqlQuery>
+#include <QThread>
+#include <memory>
+#include <vector>
 #include "compare.hpp"
 #include "correlation.hpp"
+#include "correlation_matrix.hpp"
+#include "importer.hpp"
+#include "loader.hpp"
 #include "pca.hpp"
+#include "resampler.hpp"
+#include "table.hpp"
 #include "ui_main_window.h"
 
 class MainWindow : public QMainWindow, private Ui::MainWindow {
   Q_OBJECT
  public:
   explicit MainWindow(QMainWindow* parent = nullptr);
+  ~MainWindow() override;
 
  private:
   QSettings qsettings;
 
   QSqlDatabase db;
 
+  Table* const editor;
+
+  std::vector<std::unique_ptr<Instrument>> instruments;  // in the same order as listwidget_tables_stocks
+
+  Resampler resampler;  // rollups used by the analyses
+
+  QThread* worker_thread = nullptr;
+
+  QProgressBar* progressbar_loading = nullptr;
+
   auto load_compare() -> Compare*;
   auto load_correlation() -> Correlation*;
+  auto load_correlation_matrix() -> CorrelationMatrix*;
   auto load_pca() -> PCA*;
 
   void add_table();
-  void load_saved_tables();
+  void start_loading();
+  void load_instrument(const QString& name, const int& instrument_id, const TimeSeries& series);
+  auto unload_tables() -> bool;
+
+  // binds the editor asking whether to discard the edits of the current table when they can not be saved
+
+  auto bind_editor(Instrument* instrument) -> bool;
   void clear_table(const QStackedWidget* sw);
   void remove_table(QListWidget* lw, QStackedWidget* sw);
 
@@ -35,26 +62,47 @@ class MainWindow : public QMainWindow, private Ui::MainWindow {
   void on_clear_table();
   void on_remove_table();
   void on_run_analysis();
+  void on_long_format();
+  void on_import(const bool& archive);
+  void on_export(const bool& all);
+  void on_table_ready(const QString& name, int instrument_id, const TimeSeries& series);
 
   void on_listwidget_item_changed(QListWidgetItem* item, QListWidget* lw, QStackedWidget* sw);
 
+  // Loader and Importer hand their tables to on_table_ready. Only one of them runs at a time.
+
   template <class T>
-  auto load_table(const QString& name, QStackedWidget* sw, QListWidget* lw) -> T* {
-    auto table = new T();
+  void start_worker(T* worker) {
+    qRegisterMetaType<TimeSeries>();
+
+    worker_thread = new QThread(this);
+
+    worker->moveToThread(worker_thread);
+
+    connect(worker_thread, &QThread::started, worker, &T::load);
+
+    connect(worker, &T::started, this, [&](int count) {
+      progressbar_loading->setRange(0, count);
+      progressbar_loading->setValue(0);
+      progressbar_loading->setVisible(count > 0);
+    });
 
-    table->set_database(db);
-    table->name = name;
-    table->init_model();
+    connect(worker, &T::tableReady, this, &MainWindow::on_table_ready);
 
-    sw->addWidget(table);
+    connect(worker, &T::finished, this, [&]() {
+      worker_thread->quit();
+      worker_thread->wait();
+      worker_thread->deleteLater();
+      worker_thread = nullptr;
 
-    lw->addItem(name);
+      progressbar_loading->hide();
 
-    auto added_item = lw->item(lw->count() - 1);
+      on_run_analysis();
+    });
 
-    added_item->setFlags(added_item->flags() | Qt::ItemIsEditable);
+    connect(worker_thread, &QThread::finished, worker, &QObject::deleteLater);
 
-    return table;
+    worker_thread->start();
   }
 };
 
@@ -2,6 +2,7 @@
 #define MATH_HPP
 
 #include <QVector>
+#include <algorithm>
 #include <cmath>
 
 template <class T>
@@ -27,64 +28,212 @@ template <class T>
 auto standard_deviation(const QVector<T>& input) -> QVector<T> {
   QVector<T> output(input.size(), 0);
 
-  // Calculating the standard deviation https://en.wikipedia.org/wiki/Standard_deviation
+  // Expanding window standard deviation computed in a single pass with Welford's algorithm
+  // https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Welford's_online_algorithm
 
-  T accumulated = 0.0;
+  T mean = 0.0;
+  T m2 = 0.0;
 
   for (int n = 0; n < input.size(); n++) {
-    accumulated += input[n];
+    const T delta = input[n] - mean;
 
-    T avg = accumulated / (n + 1);
+    mean += delta / (n + 1);
 
-    T sum = 0.0;
+    m2 += delta * (input[n] - mean);
 
-    for (int m = 0; m < n; m++) {
-      sum += (input[m] - avg) * (input[m] - avg);
+    output[n] = (n > 0) ? std::sqrt(std::max(m2, T(0)) / n) : 0;
+  }
+
+  return output;
+}
+
+template <class T>
+auto rolling_standard_deviation(const QVector<T>& input, const int& window) -> QVector<T> {
+  // One point has no spread, so windows shorter than two use all the previous points. The spinboxes start at one and
+  // show it as Expanding.
+
+  if (window < 2) {
+    return standard_deviation(input);
+  }
+
+  QVector<T> output(input.size(), 0);
+
+  // While the window is filling we use Welford's update. Once it is full the oldest sample is replaced by the newest
+  // one keeping the number of samples constant.
+
+  T mean = 0.0;
+  T m2 = 0.0;
+
+  for (int n = 0; n < input.size(); n++) {
+    if (n < window) {
+      const T delta = input[n] - mean;
+
+      mean += delta / (n + 1);
+
+      m2 += delta * (input[n] - mean);
+    } else {
+      const T x_new = input[n];
+      const T x_old = input[n - window];
+      const T old_mean = mean;
+
+      mean += (x_new - x_old) / window;
+
+      m2 += (x_new - x_old) * (x_new - mean + x_old - old_mean);
     }
 
-    sum = (n > 0) ? sum / n : sum;
+    const int count = std::min(n + 1, window);
 
-    output[n] = std::sqrt(sum);
+    output[n] = (count > 1) ? std::sqrt(std::max(m2, T(0)) / (count - 1)) : 0;
   }
 
   return output;
 }
 
+template <class T>
+void percent_returns(const QVector<T>& values, QVector<T>& output, const int& first, const int& last) {
+  output.resize(values.size());
+
+  // values must be in chronological order. The oldest point has no return. Only the range [first, last] is updated.
+
+  for (int n = std::max(first, 0); n <= std::min(last, values.size() - 1); n++) {
+    output[n] = (n > 0) ? 100 * (values[n] - values[n - 1]) / values[n - 1] : 0;
+  }
+}
+
+template <class T>
+auto percent_returns(const QVector<T>& values) -> QVector<T> {
+  QVector<T> output;
+
+  percent_returns(values, output, 0, values.size() - 1);
+
+  return output;
+}
+
+template <class T>
+void accumulated_return(const QVector<T>& return_perc, QVector<T>& output, const int& first) {
+  output.resize(return_perc.size());
+
+  // Cumulative product of the returns given in chronological order. The points before first are kept and the product
+  // continues from the last of them.
+
+  const int start = std::max(first, 0);
+
+  T product = (start > 0) ? output[start - 1] * 0.01 + 1.0 : 1.0;
+
+  for (int n = start; n < return_perc.size(); n++) {
+    product *= return_perc[n] * 0.01 + 1.0;
+
+    output[n] = (product - 1.0) * 100;
+  }
+}
+
+template <class T>
+auto accumulated_return(const QVector<T>& return_perc) -> QVector<T> {
+  QVector<T> output;
+
+  accumulated_return(return_perc, output, 0);
+
+  return output;
+}
+
+template <class T>
+class RunningCovariance {
+ public:
+  // Running co-moments of two variables. Samples can be added and removed in O(1)
+  // https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Covariance
+
+  void add(const T& a, const T& b) {
+    count++;
+
+    const T delta_a = a - mean_a;
+    const T delta_b = b - mean_b;
+
+    mean_a += delta_a / count;
+    mean_b += delta_b / count;
+
+    m2_a += delta_a * (a - mean_a);
+    m2_b += delta_b * (b - mean_b);
+    comoment += delta_a * (b - mean_b);
+  }
+
+  void remove(const T& a, const T& b) {
+    if (count <= 1) {
+      *this = RunningCovariance();
+
+      return;
+    }
+
+    const T old_mean_a = mean_a;
+    const T old_mean_b = mean_b;
+
+    count--;
+
+    mean_a = (mean_a * (count + 1) - a) / count;
+    mean_b = (mean_b * (count + 1) - b) / count;
+
+    m2_a -= (a - old_mean_a) * (a - mean_a);
+    m2_b -= (b - old_mean_b) * (b - mean_b);
+    comoment -= (a - old_mean_a) * (b - mean_b);
+  }
+
+  [[nodiscard]] auto correlation() const -> T {
+    const T stddev_a = std::sqrt(std::max(m2_a, T(0)));
+    const T stddev_b = std::sqrt(std::max(m2_b, T(0)));
+
+    const float tol = 0.001F;
+
+    if (stddev_a > tol && stddev_b > tol) {
+      return comoment / (stddev_a * stddev_b);
+    }
+
+    return comoment;
+  }
+
+ private:
+  int count = 0;
+
+  T mean_a = 0;
+  T mean_b = 0;
+  T m2_a = 0;
+  T m2_b = 0;
+  T comoment = 0;
+};
+
 template <class T>
 auto correlation_coefficient(const QVector<T>& a, const QVector<T>& b) -> QVector<T> {
   QVector<T> output(a.size(), 0);
-  T sum_a = 0;
-  T sum_b = 0;
 
   // calculating the Pearson correlation coefficient https://en.wikipedia.org/wiki/Pearson_correlation_coefficient
 
+  RunningCovariance<T> moments;
+
   for (int n = 0; n < a.size(); n++) {
-    sum_a += a[n];
-    sum_b += b[n];
+    moments.add(a[n], b[n]);
+
+    output[n] = moments.correlation();
+  }
 
-    T avg_a = sum_a / (n + 1);
-    T avg_b = sum_b / (n + 1);
+  return output;
+}
 
-    T variance_a = 0;
-    T variance_b = 0;
+template <class T>
+auto rolling_correlation_coefficient(const QVector<T>& a, const QVector<T>& b, const int& window) -> QVector<T> {
+  if (window < 2) {
+    return correlation_coefficient(a, b);
+  }
 
-    for (int m = 0; m <= n; m++) {
-      variance_a += (a[m] - avg_a) * (a[m] - avg_a);
-      variance_b += (b[m] - avg_b) * (b[m] - avg_b);
-    }
+  QVector<T> output(a.size(), 0);
 
-    T stddev = std::sqrt(variance_a);
-    T tstddev = std::sqrt(variance_b);
+  RunningCovariance<T> moments;
 
-    for (int m = 0; m <= n; m++) {
-      output[n] += (a[m] - avg_a) * (b[m] - avg_b);
+  for (int n = 0; n < a.size(); n++) {
+    if (n >= window) {
+      moments.remove(a[n - window], b[n - window]);
     }
 
-    const float tol = 0.001F;
+    moments.add(a[n], b[n]);
 
-    if (stddev > tol && tstddev > tol) {
-      output[n] /= (stddev * tstddev);
-    }
+    output[n] = moments.correlation();
   }
 
   return output;
@@ -1,10 +1,15 @@
 #include "model.hpp"
 #include <QColor>
-#include <QDateTime>
+#include <algorithm>
+#include "csv_funcs.hpp"
 
 Model::Model(const QSqlDatabase& db, QObject* parent) : QSqlTableModel(parent, db) {}
 
-auto Model::flags(const QModelIndex& index) -> Qt::ItemFlags {
+auto Model::flags(const QModelIndex& index) const -> Qt::ItemFlags {
+  if (index.column() == 3 || index.column() == 4) {
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+  }
+
   return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsEditable;
 }
 
@@ -17,6 +22,10 @@ auto Model::data(const QModelIndex& index, int role) const -> QVariant {
     return Qt::AlignRight;
   }
 
+  if (role == RawRole) {
+    return QSqlTableModel::data(index, Qt::EditRole);
+  }
+
   if (role == Qt::DisplayRole || role == Qt::EditRole) {
     int column = index.column();
 
@@ -24,9 +33,7 @@ auto Model::data(const QModelIndex& index, int role) const -> QVariant {
       auto v = QSqlTableModel::data(index, role);
 
       if (v.userType() == QMetaType::LongLong || v.userType() == QMetaType::Int) {
-        auto qdt = QDateTime::fromSecsSinceEpoch(v.toInt());
-
-        return qdt.toString("dd/MM/yyyy");
+        return format_date(v.toLongLong());
       }
 
       return v;
@@ -49,27 +56,133 @@ auto Model::setData(const QModelIndex& index, const QVariant& value, int role) -
     return false;
   }
 
+  bool changed = false;
+
   if (column == 1) {
     if (value.userType() == QMetaType::QString) {
-      auto qdt = QDateTime::fromString(value.toString(), "dd/MM/yyyy");
+      const auto text = value.toString().toUtf8();
+
+      qint64 date = 0;
 
-      return QSqlTableModel::setData(index, qdt.toSecsSinceEpoch(), role);
+      if (!parse_date(std::string_view(text.constData(), text.size()), date)) {
+        return false;
+      }
+
+      changed = QSqlTableModel::setData(index, date, role);
+    } else if (value.userType() == QMetaType::Int || value.userType() == QMetaType::LongLong) {
+      changed = QSqlTableModel::setData(index, value, role);
     }
+  } else if (value.userType() == QMetaType::Double) {
+    changed = QSqlTableModel::setData(index, value, role);
+  } else if (value.userType() == QMetaType::QString) {
+    changed = QSqlTableModel::setData(index, locale.toDouble(value.toString()), role);
+  }
+
+  if (changed) {
+    mark_dirty(index.row(), index.row(), column == 1);
+  }
+
+  return changed;
+}
 
-    if (value.userType() == QMetaType::Int) {
-      return QSqlTableModel::setData(index, value, role);
+auto Model::insertRows(int row, int count, const QModelIndex& parent) -> bool {
+  if (!QSqlTableModel::insertRows(row, count, parent)) {
+    return false;
+  }
+
+  shift_removed_rows(row, count);
+
+  mark_dirty(row, row + count - 1, true);
+
+  return true;
+}
+
+auto Model::removeRows(int row, int count, const QModelIndex& parent) -> bool {
+  // Rows inserted since the last submit leave the model at once. The others stay in it until the next select and are
+  // recorded. The rows are removed one at a time starting from the last so the recorded ones keep their place.
+
+  int n = row + count - 1;
+
+  for (; n >= row; n--) {
+    const int rows_before = rowCount();
+
+    if (!QSqlTableModel::removeRows(n, 1, parent)) {
+      break;
     }
 
+    if (rowCount() < rows_before) {
+      shift_removed_rows(n + 1, -1);
+    } else {
+      removed_rows.insert(n);
+    }
+  }
+
+  if (n == row + count - 1) {
     return false;
   }
 
-  if (value.userType() == QMetaType::Double) {
-    return QSqlTableModel::setData(index, value, role);
+  mark_dirty(row, row + count - 1, true);
+
+  return n < row;
+}
+
+auto Model::select() -> bool {
+  // submitAll() selects again after writing the changes, so this also forgets the rows it deleted
+
+  removed_rows.clear();
+
+  dirty_first = -1;
+  dirty_last = -1;
+  dirty_structure = false;
+
+  return QSqlTableModel::select();
+}
+
+auto Model::take_dirty_rows(int& first, int& last, bool& structural) -> bool {
+  if (dirty_first < 0) {
+    return false;
   }
 
-  if (value.userType() == QMetaType::QString) {
-    return QSqlTableModel::setData(index, locale.toDouble(value.toString()), role);
+  first = dirty_first;
+  last = dirty_last;
+  structural = dirty_structure;
+
+  dirty_first = -1;
+  dirty_last = -1;
+  dirty_structure = false;
+
+  return true;
+}
+
+auto Model::is_removed(const int& row) const -> bool {
+  return removed_rows.contains(row);
+}
+
+void Model::shift_removed_rows(const int& first, const int& offset) {
+  QSet<int> shifted;
+
+  for (const auto& row : removed_rows) {
+    shifted.insert((row >= first) ? row + offset : row);
   }
 
-  return false;
-}
\ No newline at end of file
+  removed_rows = shifted;
+}
+
+void Model::mark_dirty(const int& first, const int& last, const bool& structural) {
+  dirty_first = (dirty_first < 0) ? first : std::min(dirty_first, first);
+  dirty_last = std::max(dirty_last, last);
+
+  dirty_structure = dirty_structure || structural;
+}
+
+auto Model::raw_id(const int& row) const -> qint64 {
+  return QSqlTableModel::data(index(row, 0), Qt::EditRole).toLongLong();
+}
+
+auto Model::raw_date(const int& row) const -> qint64 {
+  return QSqlTableModel::data(index(row, 1), Qt::EditRole).toLongLong();
+}
+
+auto Model::raw_value(const int& row, const int& column) const -> double {
+  return QSqlTableModel::data(index(row, column), Qt::EditRole).toDouble();
+}
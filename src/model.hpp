@@ -2,21 +2,62 @@
 #define MODEL_BENCHMARK_HPP
 
 #include <QLocale>
+#include <QSet>
 #include <QSqlTableModel>
 
 class Model : public QSqlTableModel {
  public:
   Model(const QSqlDatabase& db, QObject* parent = nullptr);
 
-  using QSqlTableModel::flags;
-  auto flags(const QModelIndex& index) -> Qt::ItemFlags;
+  // role returning the value stored in the database without any formatting
+
+  static constexpr int RawRole = Qt::UserRole;
+
+  // the return columns are calculated from the dates and the values and can not be edited
+
+  [[nodiscard]] auto flags(const QModelIndex& index) const -> Qt::ItemFlags override;
 
   [[nodiscard]] auto data(const QModelIndex& index, int role = Qt::DisplayRole) const -> QVariant override;
 
   auto setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) -> bool override;
 
+  auto insertRows(int row, int count, const QModelIndex& parent = QModelIndex()) -> bool override;
+
+  auto removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) -> bool override;
+
+  auto select() -> bool override;
+
+  // Rows edited since the last call. Editing a date, adding or removing rows may change the order of the rows and is
+  // reported as a structural change. Returns false when nothing was edited.
+
+  auto take_dirty_rows(int& first, int& last, bool& structural) -> bool;
+
+  // Rows removed from the model that are only deleted from the database on submit. With manual submit they stay in the
+  // model until the next select.
+
+  [[nodiscard]] auto is_removed(const int& row) const -> bool;
+
+  [[nodiscard]] auto raw_id(const int& row) const -> qint64;
+
+  [[nodiscard]] auto raw_date(const int& row) const -> qint64;
+
+  [[nodiscard]] auto raw_value(const int& row, const int& column) const -> double;
+
  private:
   QLocale locale;
+
+  int dirty_first = -1;
+  int dirty_last = -1;
+
+  bool dirty_structure = false;
+
+  QSet<int> removed_rows;
+
+  void mark_dirty(const int& first, const int& last, const bool& structural);
+
+  // moves the recorded removed rows at or after first when rows are inserted or taken out of the model
+
+  void shift_removed_rows(const int& first, const int& offset);
 };
 
 #endif
\ No newline at end of file
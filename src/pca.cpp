@@ -1,15 +1,16 @@
 #include "pca.hpp"
-#include <Eigen/Core>
-#include <Eigen/Eigenvalues>
+#include "analysis_funcs.hpp"
 #include "chart_funcs.hpp"
 #include "effects.hpp"
 
-PCA::PCA(const QSqlDatabase& database, QWidget* parent)
-    : db(database), chart(new QChart()), callout(new Callout(chart)) {
+PCA::PCA(const QSqlDatabase& database, Resampler* resampler, QWidget* parent)
+    : db(database),
+      chart(new QChart()),
+      binding(chart),
+      crosshair(chart, binding.index()),
+      resampler(resampler) {
   setupUi(this);
 
-  callout->hide();
-
   // shadow effects
 
   frame_chart->setGraphicsEffect(card_shadow());
@@ -27,91 +28,9 @@ PCA::PCA(const QSqlDatabase& database, QWidget* parent)
   chart_view->setRenderHint(QPainter::Antialiasing);
   chart_view->setRubberBand(QChartView::RectangleRubberBand);
 
-  // signals
-
-  connect(button_reset_zoom, &QPushButton::clicked, this, [&]() { chart->zoomReset(); });
-  connect(spinbox_months, QOverload<int>::of(&QSpinBox::valueChanged), [&](int value) { process_tables(); });
-}
-
-void PCA::process(const QVector<Table const*>& tables) {
-  this->tables = tables;
-
-  process_tables();
-}
-
-void PCA::process_tables() {
-  clear_chart(chart);
-
-  chart->setTitle("Net Return Pricipal Component Analysis");
-
-  if (tables.size() < 2) {
-    return;
-  }
-
-  Eigen::MatrixXd data = Eigen::MatrixXd::Zero(tables.size(), spinbox_months->value());
-
-  for (int k = 0; k < tables.size(); k++) {
-    for (int n = 0; n < tables[k]->model->rowCount() && n < spinbox_months->value(); n++) {
-      data(k, n) = tables[k]->model->record(n).value("return_perc").toDouble();
-    }
-  }
-
-  // Standardizing the data https://en.wikipedia.org/wiki/Feature_scaling#Standardization_(Z-score_Normalization)
-
-  data = data.rowwise() - data.colwise().mean();
-
-  Eigen::ArrayXd stddev = (data.array() * data.array()).colwise().sum().sqrt() / std::sqrt(data.rows() - 1);
+  crosshair.watch(chart_view);
 
-  for (int n = 0; n < data.cols(); n++) {
-    double std = stddev(n);
-    const double tol = 0.0001;
-
-    for (int m = 0; m < data.rows(); m++) {
-      if (std > tol) {
-        data(m, n) /= std;
-      }
-    }
-  }
-
-  // https://en.wikipedia.org/wiki/Sample_mean_and_covariance#Sample_covariance
-
-  Eigen::MatrixXd covariance =
-      (data.rowwise() - data.colwise().mean()).transpose() * (data.rowwise() - data.colwise().mean());
-
-  if (data.rows() > 1) {
-    covariance /= (data.rows() - 1);
-  }
-
-  // Finding eigenvalues and eigenvectors. We use SelfAdjointEigenSolver because the covariance matrix is symmetric.
-
-  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver;
-
-  solver.compute(covariance);
-
-  Eigen::VectorXd eigenvalues = solver.eigenvalues();
-  Eigen::MatrixXd eigenvectors = solver.eigenvectors();
-
-  // Calculating the explained variance
-
-  double eigenvalues_sum = eigenvalues.sum();
-  Eigen::VectorXd percentage = 100 * eigenvalues / eigenvalues_sum;
-
-  double pc1_explained_variance = percentage[percentage.size() - 1];
-  double pc2_explained_variance = percentage[percentage.size() - 2];
-
-  label_pc1->setText(QString("PC1: %1%").arg(QString::number(pc1_explained_variance, 'f', 1)));
-  label_pc2->setText(QString("PC2: %1%").arg(QString::number(pc2_explained_variance, 'f', 1)));
-
-  // Projecting the data to the new space
-
-  Eigen::MatrixXd projection_matrix(eigenvectors.rows(), 2);
-
-  projection_matrix.col(0) = eigenvectors.col(eigenvectors.cols() - 1);
-  projection_matrix.col(1) = eigenvectors.col(eigenvectors.cols() - 2);
-
-  Eigen::MatrixXd pdata = data * projection_matrix;
-
-  // Showing the data in the chart
+  // the axes are kept between updates. Only the series change.
 
   QFont serif_font("Sans");
 
@@ -130,69 +49,59 @@ void PCA::process_tables() {
   chart->addAxis(axis_x, Qt::AlignBottom);
   chart->addAxis(axis_y, Qt::AlignLeft);
 
-  double xmin = 0.0;
-  double xmax = 0.0;
-  double ymin = 0.0;
-  double ymax = 0.0;
-
-  for (int n = 0; n < pdata.rows(); n++) {
-    double x = pdata(n, 0);
-    double y = pdata(n, 1);
-
-    if (n == 0) {
-      xmin = x;
-      xmax = x;
-      ymin = y;
-      ymax = y;
-    } else {
-      xmin = std::min(xmin, x);
-      xmax = std::max(xmax, x);
-      ymin = std::min(ymin, y);
-      ymax = std::max(ymax, y);
-    }
+  combo_frequency->addItems(frequency_names());
 
-    auto series = new QScatterSeries();
+  // signals
 
-    series->setName(tables[n]->name);
+  connect(button_reset_zoom, &QPushButton::clicked, this, [&]() { chart->zoomReset(); });
+  connect(combo_frequency, QOverload<int>::of(&QComboBox::currentIndexChanged), [&](int index) { process_tables(); });
+  connect(spinbox_months, QOverload<int>::of(&QSpinBox::valueChanged), [&](int value) { process_tables(); });
+}
 
-    series->append(x, y);
+void PCA::process(const QVector<Instrument const*>& tables) {
+  this->tables = tables;
+
+  process_tables();
+}
 
-    chart->addSeries(series);
+auto PCA::selected_series(const Instrument* table) const -> const TimeSeries& {
+  return resampler->series(table->name, table->series, Frequency(combo_frequency->currentIndex()));
+}
 
-    series->attachAxis(chart->axes(Qt::Horizontal)[0]);
-    series->attachAxis(chart->axes(Qt::Vertical)[0]);
+void PCA::process_tables() {
+  // the worker gets copies of the inputs
 
-    connect(series, &QLineSeries::hovered, this, [=](const QPointF& point, bool state) {
-      if (state) {
-        auto qdt = QDateTime();
+  NamedSeries inputs;
 
-        for (int n = 0; n < pdata.rows(); n++) {
-          double x = pdata(n, 0);
-          double y = pdata(n, 1);
+  for (auto& table : tables) {
+    inputs.append({table->name, selected_series(table)});
+  }
 
-          double dx = std::fabs(x - point.x());
-          double dy = std::fabs(y - point.y());
+  const int months = spinbox_months->value();
 
-          if (dx < 0.00001 && dy < 0.00001) {
-            callout->setText(QString("Fund: %1").arg(tables[n]->name));
+  scheduler.schedule([this, inputs, months](
+                         const RecomputeScheduler::IsCancelled& is_cancelled) -> RecomputeScheduler::Publish {
+    const auto projection = pca_projection(inputs, months, is_cancelled);
 
-            break;
-          }
-        }
+    if (is_cancelled()) {
+      return {};
+    }
 
-        callout->setAnchor(point);
+    return [this, projection]() {
+      chart->setTitle("Net Return Principal Component Analysis");
 
-        callout->setZValue(11);
+      binding.begin();
 
-        callout->updateGeometry();
+      if (!projection.points.empty()) {
+        label_pc1->setText(QString("PC1: %1%").arg(QString::number(projection.pc1_explained_variance, 'f', 1)));
+        label_pc2->setText(QString("PC2: %1%").arg(QString::number(projection.pc2_explained_variance, 'f', 1)));
+      }
 
-        callout->show();
-      } else {
-        callout->hide();
+      for (const auto& [name, point] : projection.points) {
+        binding.set_point(name, point.x(), point.y());
       }
-    });
-  }
 
-  chart->axes(Qt::Horizontal)[0]->setRange(xmin - 0.05 * fabs(xmin), xmax + 0.05 * fabs(xmax));
-  chart->axes(Qt::Vertical)[0]->setRange(ymin - 0.05 * fabs(ymin), ymax + 0.05 * fabs(ymax));
+      binding.end();
+    };
+  });
 }
@@ -2,27 +2,44 @@
 #define PCA_HPP
 
 #include <QSqlDatabase>
-#include "callout.hpp"
-#include "table.hpp"
+#include "chart_binding.hpp"
+#include "chart_crosshair.hpp"
+#include "instrument.hpp"
+#include "recompute_scheduler.hpp"
+#include "resampler.hpp"
 #include "ui_pca.h"
 
 class PCA : public QWidget, protected Ui::PCA {
   Q_OBJECT
  public:
-  explicit PCA(const QSqlDatabase& database, QWidget* parent = nullptr);
+  explicit PCA(const QSqlDatabase& database, Resampler* resampler, QWidget* parent = nullptr);
 
-  void process(const QVector<Table const*>& tables);
+  void process(const QVector<Instrument const*>& tables);
 
  private:
   QSqlDatabase db;
 
   QChart* chart;
 
-  Callout* callout;
+  ChartBinding binding;
 
-  QVector<Table const*> tables;
+  ChartCrosshair crosshair;
+
+  QVector<Instrument const*> tables;
+
+  // shared by the analyses so a rollup is calculated only once
+
+  Resampler* const resampler;
+
+  // declared last so the running jobs are finished before the rest of the widget goes away
+
+  RecomputeScheduler scheduler;
 
   void process_tables();
+
+  // series of a table at the frequency selected for the analysis
+
+  auto selected_series(const Instrument* table) const -> const TimeSeries&;
 };
 
 #endif
\ No newline at end of file
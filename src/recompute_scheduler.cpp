@@ -0,0 +1,105 @@
+#include "recompute_scheduler.hpp"
+#include <QRunnable>
+#include <QThreadPool>
+#include <utility>
+
+namespace {
+
+// time given to the controls to send more changes before the calculation starts
+
+constexpr int coalesce_interval = 30;
+
+class Task : public QRunnable {
+ public:
+  explicit Task(std::function<void()> function) : function(std::move(function)) {}
+
+  void run() override { function(); }
+
+ private:
+  std::function<void()> function;
+};
+
+}  // namespace
+
+RecomputeScheduler::RecomputeScheduler(QObject* parent) : QObject(parent), state(std::make_shared<State>()) {
+  state->owner = this;
+
+  timer.setSingleShot(true);
+  timer.setInterval(coalesce_interval);
+
+  connect(&timer, &QTimer::timeout, this, &RecomputeScheduler::start_pending);
+}
+
+RecomputeScheduler::~RecomputeScheduler() {
+  // the running jobs see that they are stale and return early
+
+  cancel();
+
+  QMutexLocker locker(&state->mutex);
+
+  state->owner = nullptr;
+}
+
+void RecomputeScheduler::schedule(Job job) {
+  state->generation++;
+
+  pending = std::move(job);
+
+  if (!timer.isActive()) {
+    timer.start();
+  }
+}
+
+void RecomputeScheduler::cancel() {
+  state->generation++;
+
+  pending = nullptr;
+
+  timer.stop();
+}
+
+void RecomputeScheduler::start_pending() {
+  if (!pending) {
+    return;
+  }
+
+  const quint64 id = state->generation;
+
+  auto job = std::move(pending);
+
+  pending = nullptr;
+
+  // jobs that became stale before they got a thread return as soon as they start
+
+  QThreadPool::globalInstance()->start(new Task([state = state, id, job]() {
+    const auto is_cancelled = [state, id]() { return state->generation != id; };
+
+    if (is_cancelled()) {
+      return;
+    }
+
+    auto publish = job(is_cancelled);
+
+    if (!publish || is_cancelled()) {
+      return;
+    }
+
+    // The lock keeps the scheduler alive while the call is queued. A queued call is dropped if the scheduler is
+    // destroyed before it is delivered.
+
+    QMutexLocker locker(&state->mutex);
+
+    if (state->owner == nullptr) {
+      return;
+    }
+
+    QMetaObject::invokeMethod(
+        state->owner,
+        [state, id, publish]() {
+          if (state->generation == id) {
+            publish();
+          }
+        },
+        Qt::QueuedConnection);
+  }));
+}
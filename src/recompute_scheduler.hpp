@@ -0,0 +1,59 @@
+#ifndef RECOMPUTE_SCHEDULER_HPP
+#define RECOMPUTE_SCHEDULER_HPP
+
+#include <QMutex>
+#include <QObject>
+#include <QTimer>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// Runs the calculations behind a chart in the global thread pool, which every chart shares. Changes arriving while the
+// timer runs are merged and only the last job scheduled is started. A job is stale once another one is scheduled: it
+// should stop when is_cancelled() returns true, and what it hands back is not published. The publishing function runs
+// in the gui thread.
+//
+// Jobs must not read anything the gui thread may change. They work on copies taken when they are scheduled. The
+// QVector columns of a TimeSeries are shared, so copying it is cheap.
+
+class RecomputeScheduler : public QObject {
+  Q_OBJECT
+ public:
+  using IsCancelled = std::function<bool()>;
+  using Publish = std::function<void()>;
+  using Job = std::function<Publish(const IsCancelled& is_cancelled)>;
+
+  explicit RecomputeScheduler(QObject* parent = nullptr);
+  ~RecomputeScheduler() override;
+
+  RecomputeScheduler(const RecomputeScheduler&) = delete;
+  auto operator=(const RecomputeScheduler&) -> RecomputeScheduler& = delete;
+
+  void schedule(Job job);
+
+  // the pending job and the ones already running will not publish anything
+
+  void cancel();
+
+ private:
+  // Shared with the jobs because the global pool may still run them after the scheduler is destroyed. The owner is
+  // cleared then, so nothing is published.
+
+  struct State {
+    std::atomic<quint64> generation{0};
+
+    QMutex mutex;
+
+    RecomputeScheduler* owner = nullptr;
+  };
+
+  QTimer timer;
+
+  std::shared_ptr<State> state;
+
+  Job pending;
+
+  void start_pending();
+};
+
+#endif
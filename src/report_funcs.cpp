@@ -0,0 +1,439 @@
+#include "report_funcs.hpp"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QGraphicsScene>
+#include <QImage>
+#include <QLocale>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QPicture>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSqlDatabase>
+#include <QThread>
+#include <QThreadPool>
+#include <QtCharts>
+#include <array>
+#include <atomic>
+#include <future>
+#include <utility>
+#include <vector>
+#include "analysis_funcs.hpp"
+#include "chart_binding.hpp"
+#include "chart_funcs.hpp"
+#include "db_funcs.hpp"
+#include "instrument.hpp"
+#include "loader.hpp"
+#include "math.hpp"
+
+namespace {
+
+const QString connection_name = "report";
+
+// charts with more series than this do not show the legend. It would leave no room for the plot.
+
+constexpr int max_legend_entries = 40;
+
+// files recorded but not written yet, per thread of the pool. Keeps the memory bounded when the gui thread draws the
+// charts faster than the pool can encode them.
+
+constexpr int pending_files_per_thread = 4;
+
+const std::array<std::pair<CompareChart, const char*>, 4> compare_charts = {
+    {{CompareChart::return_perc, "compare_return"},
+     {CompareChart::volatility, "compare_volatility"},
+     {CompareChart::accumulated_return, "compare_accumulated_return"},
+     {CompareChart::accumulated_return_second_derivative, "compare_accumulated_return_second_derivative"}}};
+
+// chart drawn offscreen. Its series are kept from one table to the next like in the widgets.
+
+struct Page {
+  QGraphicsScene scene;
+
+  QChart* const chart;  // owned by the scene
+
+  ChartBinding binding;
+
+  explicit Page(const QSize& size) : chart(new QChart()), binding(chart) {
+    chart->setTheme(QChart::ChartThemeLight);
+    chart->legend()->setAlignment(Qt::AlignRight);
+
+    scene.addItem(chart);
+    scene.setSceneRect(QRectF(QPointF(0, 0), size));
+
+    chart->setGeometry(scene.sceneRect());
+  }
+
+  void set_lines(const QVector<ChartLine>& lines) {
+    binding.begin();
+
+    for (const auto& line : lines) {
+      binding.set_line(line.key, line.dates, line.values);
+    }
+
+    binding.end();
+
+    chart->legend()->setVisible(lines.size() <= max_legend_entries);
+  }
+};
+
+// Turns a recorded chart into a file. The scene of a chart can only be used from the gui thread, but a QPicture can be
+// played back in any thread, so the rasterization and the png or pdf encoding happen here.
+
+class FileWriter : public QRunnable {
+ public:
+  FileWriter(QPicture picture,
+             QString path,
+             const ReportOptions& options,
+             std::atomic<int>& failures,
+             QSemaphore& pending)
+      : picture(std::move(picture)),
+        path(std::move(path)),
+        format(options.format),
+        size(options.size),
+        failures(failures),
+        pending(pending) {}
+
+  void run() override {
+    if (!((format == "pdf") ? write_pdf() : write_png())) {
+      qDebug() << "failed to write " + path.toUtf8();
+
+      failures++;
+    }
+
+    pending.release();
+  }
+
+ private:
+  QPicture picture;
+
+  QString path;
+
+  QString format;
+
+  QSize size;
+
+  std::atomic<int>& failures;
+
+  QSemaphore& pending;
+
+  auto write_png() -> bool {
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+
+    image.fill(Qt::white);
+
+    QPainter painter(&image);
+
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    picture.play(&painter);
+
+    painter.end();
+
+    return image.save(path, "PNG");
+  }
+
+  auto write_pdf() -> bool {
+    QPdfWriter writer(path);
+
+    // one point per pixel of the chart
+
+    writer.setPageSize(QPageSize(QSizeF(size), QPageSize::Point));
+    writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+    writer.setResolution(72);
+
+    QPainter painter;
+
+    if (!painter.begin(&writer)) {
+      return false;
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    picture.play(&painter);
+
+    return painter.end();
+  }
+};
+
+class ReportWriter {
+ public:
+  explicit ReportWriter(const ReportOptions& options)
+      : options(options), pending(pending_files_per_thread * QThread::idealThreadCount()) {
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+  }
+
+  // records the chart and leaves the file to the thread pool
+
+  void write(Page& page, const QString& path) {
+    // the layout of the chart and the points of the series pyramids are updated by posted events
+
+    QCoreApplication::sendPostedEvents();
+
+    const QRect rect(QPoint(0, 0), options.size);
+
+    QPicture picture;
+
+    picture.setBoundingRect(rect);
+
+    QPainter painter(&picture);
+
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    page.scene.render(&painter, rect, rect);
+
+    painter.end();
+
+    pending.acquire();
+
+    pool.start(new FileWriter(picture, path + "." + options.format, options, failures, pending));
+
+    count++;
+  }
+
+  // waits for the files and returns false when any of them could not be written
+
+  auto finish() -> bool {
+    pool.waitForDone();
+
+    qInfo() << "Report files written:" << count - failures << "of" << count;
+
+    return failures == 0;
+  }
+
+ private:
+  const ReportOptions& options;
+
+  QSemaphore pending;
+
+  std::atomic<int> failures{0};
+
+  int count = 0;
+
+  // declared last so it waits for the files before the counters they use are destroyed
+
+  QThreadPool pool;
+};
+
+// table names become file names
+
+auto file_name(const QString& name) -> QString {
+  return QString(name).replace(QRegularExpression("[^A-Za-z0-9_.-]"), "_");
+}
+
+// The report never writes to the database. It is opened read only and a schema older than the one the program creates
+// is reported instead of migrated.
+
+auto check_database(const QString& path) -> bool {
+  bool opened = false;
+  bool current = false;
+
+  {
+    auto db = QSqlDatabase::addDatabase("QSQLITE", connection_name);
+
+    db.setDatabaseName(path);
+    db.setConnectOptions("QSQLITE_OPEN_READONLY");
+
+    opened = db.open();
+
+    if (opened) {
+      current = schema_is_current(db);
+
+      db.close();
+    }
+  }
+
+  // the connection can only be removed after every object using it was destroyed
+
+  QSqlDatabase::removeDatabase(connection_name);
+
+  if (!opened) {
+    qCritical("The report failed to open the database file!");
+  } else if (!current) {
+    qCritical("The database schema is older than this program. Open the database in the program once to update it.");
+  }
+
+  return opened && current;
+}
+
+}  // namespace
+
+auto write_report(const ReportOptions& options) -> bool {
+  QElapsedTimer timer;
+
+  timer.start();
+
+  // opening a missing file would create an empty database
+
+  if (!QFileInfo::exists(options.database_path)) {
+    qCritical() << "Database file not found:" << options.database_path;
+
+    return false;
+  }
+
+  const QDir output(options.output_dir);
+
+  if (!output.mkpath("tables")) {
+    qCritical() << "Failed to create the report folder:" << options.output_dir;
+
+    return false;
+  }
+
+  if (!check_database(options.database_path)) {
+    return false;
+  }
+
+  // the loader of the main window reads the tables in this thread without writing the returns or the series cache
+
+  QVector<Instrument> instruments;
+
+  Loader loader(options.database_path, false, true);
+
+  QObject::connect(&loader, &Loader::tableReady, [&](const QString& name, int instrument_id, const TimeSeries& series) {
+    instruments.append({name, instrument_id, series});
+  });
+
+  loader.load();
+
+  qInfo() << "Tables in the report:" << instruments.size();
+
+  // The analyses are calculated in other threads while the charts of the tables are drawn. They work on copies of the
+  // rolled up series because the resampler is not thread-safe.
+
+  Resampler resampler;
+
+  NamedSeries inputs;
+
+  for (const auto& instrument : instruments) {
+    inputs.append({instrument.name, resampler.series(instrument.name, instrument.series, options.frequency)});
+  }
+
+  const auto fund = (options.fund.isEmpty() && !instruments.empty()) ? instruments.first().name : options.fund;
+
+  const IsCancelled never = []() { return false; };
+
+  std::vector<std::future<QVector<ChartLine>>> compare_results;
+
+  for (const auto& chart : compare_charts) {
+    const auto kind = chart.first;
+
+    compare_results.push_back(std::async(std::launch::async, [&, kind]() {
+      return compare_lines(inputs, kind, options.days, options.window, never);
+    }));
+  }
+
+  auto correlation_result = std::async(std::launch::async, [&]() {
+    return correlation_lines(inputs, fund, options.months, options.window, JoinMode::exact, never);
+  });
+
+  auto pca_result = std::async(std::launch::async, [&]() { return pca_projection(inputs, options.months, never); });
+
+  ReportWriter writer(options);
+
+  // the charts of the table editor
+
+  Page value_page(options.size);
+  Page return_page(options.size);
+
+  add_axes_to_chart(value_page.chart, QLocale().currencySymbol());
+  add_axes_to_chart(return_page.chart, "%");
+
+  for (const auto& instrument : instruments) {
+    const auto& series = instrument.series;
+
+    const auto path = output.filePath("tables/" + file_name(instrument.name));
+
+    value_page.chart->setTitle(instrument.name.toUpper());
+
+    value_page.set_lines({{"Value", series.dates, series.values}});
+
+    writer.write(value_page, path + "_value");
+
+    const auto start = series.tail_start(options.days);
+
+    return_page.chart->setTitle(instrument.name.toUpper());
+
+    return_page.set_lines(
+        {{"Accumulated Return", series.dates.mid(start), accumulated_return(series.return_perc.mid(start))}});
+
+    writer.write(return_page, path + "_accumulated_return");
+  }
+
+  // compare
+
+  Page compare_page(options.size);
+
+  add_axes_to_chart(compare_page.chart, "%");
+
+  for (size_t n = 0; n < compare_charts.size(); n++) {
+    const auto& [kind, name] = compare_charts[n];
+
+    compare_page.chart->setTitle(compare_title(kind));
+
+    compare_page.chart->axes(Qt::Vertical)[0]->setTitleText(compare_unit(kind));
+
+    compare_page.set_lines(compare_results[n].get());
+
+    writer.write(compare_page, output.filePath(name));
+  }
+
+  // correlation
+
+  Page correlation_page(options.size);
+
+  add_axes_to_chart(correlation_page.chart, "");
+
+  correlation_page.chart->setTitle(QString("Correlation Coefficient: %1").arg(fund.toUpper()));
+
+  correlation_page.set_lines(correlation_result.get());
+
+  correlation_page.chart->axes(Qt::Vertical)[0]->setRange(-1.0, 1.0);
+
+  writer.write(correlation_page, output.filePath("correlation"));
+
+  // pca
+
+  Page pca_page(options.size);
+
+  const auto projection = pca_result.get();
+
+  const QFont serif_font("Sans");
+
+  auto axis_x = new QValueAxis();
+  auto axis_y = new QValueAxis();
+
+  axis_x->setTitleText(QString("PC1: %1%").arg(QString::number(projection.pc1_explained_variance, 'f', 1)));
+  axis_x->setLabelFormat("%.2f");
+  axis_x->setTitleFont(serif_font);
+
+  axis_y->setTitleText(QString("PC2: %1%").arg(QString::number(projection.pc2_explained_variance, 'f', 1)));
+  axis_y->setLabelFormat("%.2f");
+  axis_y->setTitleFont(serif_font);
+
+  pca_page.chart->addAxis(axis_x, Qt::AlignBottom);
+  pca_page.chart->addAxis(axis_y, Qt::AlignLeft);
+
+  pca_page.chart->setTitle("Net Return Principal Component Analysis");
+
+  pca_page.binding.begin();
+
+  for (const auto& [name, point] : projection.points) {
+    pca_page.binding.set_point(name, point.x(), point.y());
+  }
+
+  pca_page.binding.end();
+
+  pca_page.chart->legend()->setVisible(projection.points.size() <= max_legend_entries);
+
+  writer.write(pca_page, output.filePath("pca"));
+
+  const bool written = writer.finish();
+
+  qInfo() << "Report written to" << options.output_dir << "in" << timer.elapsed() << "ms";
+
+  return written;
+}
@@ -0,0 +1,36 @@
+#ifndef REPORT_FUNCS_HPP
+#define REPORT_FUNCS_HPP
+
+#include <QSize>
+#include <QString>
+#include "resampler.hpp"
+
+// Settings of the batch report. The defaults are the ones the analysis widgets start with.
+
+struct ReportOptions {
+  QString database_path;
+
+  QString output_dir;
+
+  QString format = "png";  // png or pdf
+
+  QSize size = QSize(1600, 900);
+
+  Frequency frequency = Frequency::raw;
+
+  int days = 30;  // rows of the return charts
+
+  int months = 30;  // rows of the correlation and pca
+
+  int window = 0;  // rolling window of the volatility and correlation. Below 2 it uses all the rows.
+
+  QString fund;  // reference of the correlation chart. The first table when empty.
+};
+
+// Renders the charts of every table and the compare, correlation and pca charts to one file each, without creating
+// any window. A QApplication must exist but it may run on the offscreen platform. Returns false when the database
+// could not be read or a file could not be written.
+
+auto write_report(const ReportOptions& options) -> bool;
+
+#endif
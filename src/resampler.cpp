@@ -0,0 +1,172 @@
+#include "resampler.hpp"
+#include <QDateTime>
+#include <algorithm>
+#include <limits>
+#include "math.hpp"
+
+namespace {
+
+auto period_start(const QDate& date, const Frequency& frequency) -> QDate {
+  switch (frequency) {
+    case Frequency::weekly:
+      return date.addDays(1 - date.dayOfWeek());
+    case Frequency::monthly:
+      return {date.year(), date.month(), 1};
+    case Frequency::quarterly:
+      return {date.year(), 3 * ((date.month() - 1) / 3) + 1, 1};
+    case Frequency::yearly:
+      return {date.year(), 1, 1};
+    default:
+      return date;
+  }
+}
+
+auto next_period_start(const QDate& start, const Frequency& frequency) -> QDate {
+  switch (frequency) {
+    case Frequency::weekly:
+      return start.addDays(7);
+    case Frequency::monthly:
+      return start.addMonths(1);
+    case Frequency::quarterly:
+      return start.addMonths(3);
+    case Frequency::yearly:
+      return start.addYears(1);
+    default:
+      return start.addDays(1);
+  }
+}
+
+auto local_midnight(const QDate& date) -> qint64 {
+  return QDateTime(date, QTime(0, 0)).toMSecsSinceEpoch();
+}
+
+// first row where the columns differ from the ones the rollup was made from
+
+template <class T>
+auto first_difference(const QVector<T>& a, const QVector<T>& b) -> int {
+  if (a.constData() == b.constData()) {
+    return a.size();
+  }
+
+  const int size = std::min(a.size(), b.size());
+
+  return int(std::mismatch(a.constBegin(), a.constBegin() + size, b.constBegin()).first - a.constBegin());
+}
+
+void truncate(Rollup& rollup, const int& periods) {
+  auto& series = rollup.series;
+
+  series.resize(periods);
+
+  rollup.open.resize(periods);
+  rollup.high.resize(periods);
+  rollup.low.resize(periods);
+  rollup.first_row.resize(periods);
+}
+
+// Rolls up the source rows from first_row on. The periods before it are kept.
+
+void resample(const TimeSeries& source, const Frequency& frequency, const int& first_row, Rollup& rollup) {
+  auto& series = rollup.series;
+
+  const int kept = series.size();
+
+  // the interval of the current period. The calendar is only consulted when a row falls outside of it.
+
+  qint64 period_begin = std::numeric_limits<qint64>::max();
+  qint64 period_end = std::numeric_limits<qint64>::min();
+
+  double product = 1.0;
+
+  for (int n = first_row; n < source.size(); n++) {
+    const qint64 date = source.dates[n];
+    const double value = source.values[n];
+
+    if (date < period_begin || date >= period_end) {
+      const auto start = period_start(QDateTime::fromMSecsSinceEpoch(date).date(), frequency);
+
+      period_begin = local_midnight(start);
+      period_end = local_midnight(next_period_start(start, frequency));
+
+      series.ids.append(0);
+      series.dates.append(period_begin);
+      series.values.append(value);
+      series.return_perc.append(0.0);
+      series.accumulated_return_perc.append(0.0);
+
+      rollup.open.append(value);
+      rollup.high.append(value);
+      rollup.low.append(value);
+      rollup.first_row.append(n);
+
+      product = 1.0;
+    }
+
+    const int k = series.size() - 1;
+
+    product *= source.return_perc[n] * 0.01 + 1.0;
+
+    series.ids[k] = source.ids.isEmpty() ? 0 : source.ids[n];
+    series.values[k] = value;
+    series.return_perc[k] = (product - 1.0) * 100;
+
+    rollup.high[k] = std::max(rollup.high[k], value);
+    rollup.low[k] = std::min(rollup.low[k], value);
+  }
+
+  accumulated_return(series.return_perc, series.accumulated_return_perc, kept);
+}
+
+}  // namespace
+
+auto Resampler::series(const QString& name, const TimeSeries& source, const Frequency& frequency)
+    -> const TimeSeries& {
+  if (frequency == Frequency::raw) {
+    return source;
+  }
+
+  return rollup(name, source, frequency).series;
+}
+
+auto Resampler::rollup(const QString& name, const TimeSeries& source, const Frequency& frequency) -> const Rollup& {
+  auto& entry = entries[{name, frequency}];
+
+  auto& rollup = entry.rollup;
+
+  // Rows before the first difference still belong to the same periods. The period holding it is calculated again.
+
+  const int changed =
+      std::min({first_difference(entry.dates, source.dates), first_difference(entry.values, source.values),
+                first_difference(entry.return_perc, source.return_perc)});
+
+  if (changed == source.size() && changed == entry.dates.size()) {
+    return rollup;
+  }
+
+  const int period = int(std::upper_bound(rollup.first_row.begin(), rollup.first_row.end(), changed) -
+                         rollup.first_row.begin()) - 1;
+
+  const int kept = std::max(period, 0);
+
+  const int first_row = (kept < rollup.first_row.size()) ? rollup.first_row[kept] : 0;
+
+  truncate(rollup, kept);
+
+  resample(source, frequency, first_row, rollup);
+
+  entry.dates = source.dates;
+  entry.values = source.values;
+  entry.return_perc = source.return_perc;
+
+  return rollup;
+}
+
+void Resampler::remove(const QString& name) {
+  for (auto it = entries.begin(); it != entries.end();) {
+    it = (it->first.first == name) ? entries.erase(it) : std::next(it);
+  }
+}
+
+void Resampler::clear() {
+  entries.clear();
+}
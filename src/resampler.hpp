@@ -0,0 +1,64 @@
+#ifndef RESAMPLER_HPP
+#define RESAMPLER_HPP
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <map>
+#include <utility>
+#include "time_series.hpp"
+
+// Frequencies an analysis can work at. raw uses the rows as they are stored.
+
+enum class Frequency { raw, weekly, monthly, quarterly, yearly };
+
+// names shown in the frequency selectors in the same order as the enum
+
+inline auto frequency_names() -> QStringList {
+  return {"Raw", "Weekly", "Monthly", "Quarterly", "Yearly"};
+}
+
+// Series rolled up into calendar periods. The dates are the local midnight of the first day of each period (weeks
+// start on Monday) so instruments sampled at different frequencies fall on the same dates. The values are the last
+// close of the period, the returns compound the returns of the rows inside it and the ids are the ones of the last row.
+
+struct Rollup {
+  TimeSeries series;
+
+  QVector<double> open;
+  QVector<double> high;
+  QVector<double> low;
+
+  // first source row of every period
+
+  QVector<int> first_row;
+};
+
+// Keeps the rollups of every instrument and frequency. A rollup is checked against the series it came from whenever it
+// is asked for and only the periods starting at the first row that changed are calculated again.
+
+class Resampler {
+ public:
+  auto series(const QString& name, const TimeSeries& source, const Frequency& frequency) -> const TimeSeries&;
+
+  auto rollup(const QString& name, const TimeSeries& source, const Frequency& frequency) -> const Rollup&;
+
+  void remove(const QString& name);
+
+  void clear();
+
+ private:
+  struct Entry {
+    Rollup rollup;
+
+    // Columns the rollup was made from. They share the data with the source until it is modified.
+
+    QVector<qint64> dates;
+    QVector<double> values;
+    QVector<double> return_perc;
+  };
+
+  std::map<std::pair<QString, Frequency>, Entry> entries;
+};
+
+#endif
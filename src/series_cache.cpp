@@ -0,0 +1,172 @@
+#include "series_cache.hpp"
+#include <QDebug>
+#include <QSaveFile>
+#include "binary_funcs.hpp"
+
+namespace {
+
+constexpr quint32 magic = 0x434b5453;  // "STKC" when read in the byte order it was written
+
+// increased every time the layout of the file changes
+
+constexpr quint32 format_version = 3;
+
+constexpr qint64 header_size = 4 * sizeof(quint32);
+
+constexpr qint64 entry_header_size = 2 * sizeof(quint32) + 2 * sizeof(qint64);
+
+// ids, dates, values, return_perc and accumulated_return_perc. All of them 8 bytes wide.
+
+constexpr qint64 row_size = 5 * sizeof(qint64);
+
+}  // namespace
+
+SeriesCache::SeriesCache(const QString& path) {
+  file.setFileName(path);
+
+  if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+    return;
+  }
+
+  const qint64 size = file.size();
+
+  if (size < header_size) {
+    return;
+  }
+
+  // The mapping stays valid until the file is closed. save() replaces the file without touching the mapped one.
+
+  const uchar* data = file.map(0, size);
+
+  if (data == nullptr) {
+    qDebug() << "failed to map the series cache: " + file.errorString().toUtf8();
+
+    return;
+  }
+
+  read_index(data, size);
+}
+
+void SeriesCache::read_index(const uchar* data, const qint64& size) {
+  quint32 header[4];
+
+  std::memcpy(header, data, sizeof(header));
+
+  if (header[0] != magic || header[1] != format_version) {
+    qDebug() << "the series cache was written by another version and will be rebuilt";
+
+    return;
+  }
+
+  const uchar* p = data + header_size;
+  const uchar* end = data + size;
+
+  for (quint32 n = 0; n < header[2]; n++) {
+    quint32 name_size = 0;
+    Entry entry{};
+
+    if (end - p < entry_header_size) {
+      entries.clear();
+
+      return;
+    }
+
+    read_value(p, name_size);
+
+    p += sizeof(quint32);
+
+    if (end - p < padded(name_size) + 2 * qint64(sizeof(qint64))) {
+      entries.clear();
+
+      return;
+    }
+
+    const auto name = QString::fromUtf8(reinterpret_cast<const char*>(p), int(name_size));
+
+    p += padded(name_size);
+
+    read_value(p, entry.version);
+    read_value(p, entry.rows);
+
+    if (entry.rows < 0 || (end - p) / row_size < entry.rows) {
+      qDebug() << "the series cache is truncated and will be rebuilt";
+
+      entries.clear();
+
+      return;
+    }
+
+    entry.columns = p;
+
+    entries.insert(name, entry);
+
+    p += row_size * entry.rows;
+  }
+}
+
+auto SeriesCache::find(const QString& name, const qint64& version, TimeSeries& series) const -> bool {
+  auto it = entries.constFind(name);
+
+  if (it == entries.constEnd() || it->version != version) {
+    return false;
+  }
+
+  const uchar* src = it->columns;
+
+  series.resize(int(it->rows));
+
+  read_array(src, series.ids.data(), it->rows);
+  read_array(src, series.dates.data(), it->rows);
+  read_array(src, series.values.data(), it->rows);
+  read_array(src, series.return_perc.data(), it->rows);
+  read_array(src, series.accumulated_return_perc.data(), it->rows);
+
+  return true;
+}
+
+void SeriesCache::insert(const QString& name, const qint64& version, const TimeSeries& series) {
+  const int rows = series.size();
+
+  if (series.ids.size() != rows || series.values.size() != rows || series.return_perc.size() != rows ||
+      series.accumulated_return_perc.size() != rows) {
+    return;
+  }
+
+  updated.insert(name, {version, series});
+}
+
+auto SeriesCache::save() -> bool {
+  // The new file is written next to the old one and renamed over it only when complete
+
+  QSaveFile out(file.fileName());
+
+  if (!out.open(QIODevice::WriteOnly)) {
+    qDebug() << "failed to write the series cache: " + out.errorString().toUtf8();
+
+    return false;
+  }
+
+  bool ok = write_value(out, magic) && write_value(out, format_version) && write_value(out, quint32(updated.size())) &&
+            write_value(out, quint32(0));
+
+  for (auto it = updated.constBegin(); ok && it != updated.constEnd(); ++it) {
+    const auto& series = it.value().second;
+
+    ok = write_name(out, it.key()) && write_value(out, it.value().first) && write_value(out, qint64(series.size())) &&
+         write_array(out, series.ids.constData(), series.size()) &&
+         write_array(out, series.dates.constData(), series.size()) &&
+         write_array(out, series.values.constData(), series.size()) &&
+         write_array(out, series.return_perc.constData(), series.size()) &&
+         write_array(out, series.accumulated_return_perc.constData(), series.size());
+  }
+
+  if (!ok) {
+    qDebug() << "failed to write the series cache: " + out.errorString().toUtf8();
+
+    out.cancelWriting();
+
+    return false;
+  }
+
+  return out.commit();
+}
@@ -0,0 +1,45 @@
+#ifndef SERIES_CACHE_HPP
+#define SERIES_CACHE_HPP
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include "time_series.hpp"
+
+// Binary file holding the computed series of every table. It is memory mapped when it is opened and an entry is only
+// used while the version saved with it matches the one the database has for the table. The file is written in the
+// native byte order and is discarded when it comes from a machine with a different one.
+//
+// Layout: a header with the magic, the format version and the entry count followed by the entries. Every entry has
+// its name size, the utf8 name padded to 8 bytes, version and row count and then the ids, dates, values, return_perc
+// and accumulated_return_perc columns.
+
+class SeriesCache {
+ public:
+  explicit SeriesCache(const QString& path);
+
+  auto find(const QString& name, const qint64& version, TimeSeries& series) const -> bool;
+
+  // the entries inserted are the only ones written by save()
+
+  void insert(const QString& name, const qint64& version, const TimeSeries& series);
+
+  auto save() -> bool;
+
+ private:
+  struct Entry {
+    qint64 version;
+    qint64 rows;
+    const uchar* columns;
+  };
+
+  QFile file;
+
+  QHash<QString, Entry> entries;
+
+  QHash<QString, QPair<qint64, TimeSeries>> updated;
+
+  void read_index(const uchar* data, const qint64& size);
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "series_pyramid.hpp"
+#include <algorithm>
+#include <numeric>
+#include "chart_funcs.hpp"
+
+namespace {
+
+// ranges with up to this many rows per pixel still go through LTTB
+
+constexpr int lttb_rows_per_pixel = 8;
+
+// the pyramid stops growing when its top level has fewer buckets than this
+
+constexpr int min_pyramid_buckets = 256;
+
+}  // namespace
+
+SeriesPyramid::SeriesPyramid(QChart* chart,
+                             QXYSeries* series,
+                             const QVector<qint64>& dates,
+                             const QVector<double>& values)
+    : QObject(series), chart(chart), series(series), dates(dates), values(values) {
+  build();
+
+  if (auto axis = dynamic_cast<QDateTimeAxis*>(chart->axes(Qt::Horizontal)[0]); axis != nullptr) {
+    connect(axis, &QDateTimeAxis::rangeChanged, this, &SeriesPyramid::refresh);
+  }
+
+  // the number of points follows the width of the plot area
+
+  connect(chart, &QChart::plotAreaChanged, this, &SeriesPyramid::refresh);
+
+  refresh();
+}
+
+void SeriesPyramid::set_data(const QVector<qint64>& dates, const QVector<double>& values) {
+  this->dates = dates;
+  this->values = values;
+
+  build();
+
+  refresh();
+}
+
+auto SeriesPyramid::find(const QXYSeries* series) -> SeriesPyramid* {
+  return series->findChild<SeriesPyramid*>(QString(), Qt::FindDirectChildrenOnly);
+}
+
+void SeriesPyramid::build() {
+  levels.clear();
+
+  // Level 0 is made from pairs of rows. Every other level merges two buckets of the one below it.
+
+  QVector<int> rows(dates.size());
+
+  std::iota(rows.begin(), rows.end(), 0);
+
+  const QVector<int>* below = &rows;
+
+  int entries_per_bucket = 1;
+
+  while (below->size() / entries_per_bucket > 2 * min_pyramid_buckets) {
+    const auto& candidates = *below;
+
+    const int group = 2 * entries_per_bucket;
+
+    QVector<int> level;
+
+    level.reserve(candidates.size() / group * 2 + 2);
+
+    for (int begin = 0; begin < candidates.size(); begin += group) {
+      const int end = std::min(begin + group, candidates.size());
+
+      int lo = candidates[begin];
+      int hi = candidates[begin];
+
+      for (int n = begin + 1; n < end; n++) {
+        lo = (values[candidates[n]] < values[lo]) ? candidates[n] : lo;
+        hi = (values[candidates[n]] > values[hi]) ? candidates[n] : hi;
+      }
+
+      level.append(std::min(lo, hi));
+      level.append(std::max(lo, hi));
+    }
+
+    levels.push_back(level);
+
+    below = &levels.back();
+
+    entries_per_bucket = 2;
+  }
+}
+
+void SeriesPyramid::refresh() {
+  const auto axes = chart->axes(Qt::Horizontal);
+
+  auto axis = axes.empty() ? nullptr : dynamic_cast<QDateTimeAxis*>(axes[0]);
+
+  if (axis == nullptr || dates.empty()) {
+    series->clear();
+
+    return;
+  }
+
+  // one row on each side of the range so the line reaches the borders of the plot
+
+  const auto xmin = axis->min().toMSecsSinceEpoch();
+  const auto xmax = axis->max().toMSecsSinceEpoch();
+
+  const int lower = int(std::lower_bound(dates.constBegin(), dates.constEnd(), xmin) - dates.constBegin());
+  const int upper = int(std::upper_bound(dates.constBegin(), dates.constEnd(), xmax) - dates.constBegin());
+
+  const int first = std::max(lower - 1, 0);
+  const int last = std::min(upper + 1, dates.size());
+
+  series->replace(points(first, last, chart_resolution(chart)));
+}
+
+auto SeriesPyramid::points(const int& first, const int& last, const int& resolution) const -> QVector<QPointF> {
+  const int count = last - first;
+
+  if (count <= lttb_rows_per_pixel * resolution || levels.empty()) {
+    return downsample_lttb(dates.mid(first, count), values.mid(first, count), resolution);
+  }
+
+  // The coarsest level still giving at least one point per pixel. Every bucket gives two points.
+
+  int k = 0;
+
+  while (k + 1 < int(levels.size()) && 2 * (count / (2 << (k + 1))) >= resolution) {
+    k++;
+  }
+
+  const auto& level = levels[k];
+
+  const int bucket_size = 2 << k;
+
+  const int first_bucket = first / bucket_size;
+  const int last_bucket = std::min((last - 1) / bucket_size, level.size() / 2 - 1);
+
+  QVector<QPointF> output;
+
+  output.reserve(2 * (last_bucket - first_bucket + 1));
+
+  for (int b = first_bucket; b <= last_bucket; b++) {
+    for (const int& row : {level[2 * b], level[2 * b + 1]}) {
+      if (output.empty() || output.last().x() != dates[row] || output.last().y() != values[row]) {
+        output.append(QPointF(dates[row], values[row]));
+      }
+    }
+  }
+
+  return output;
+}
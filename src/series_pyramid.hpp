@@ -0,0 +1,48 @@
+#ifndef SERIES_PYRAMID_HPP
+#define SERIES_PYRAMID_HPP
+
+#include <QObject>
+#include <QtCharts>
+#include <vector>
+
+// Level of detail of a line series. The full resolution data is kept here and the series only receives the points
+// inside the visible date range at about one point per pixel. It is calculated again every time the date axis changes
+// its range, which includes the rubber band zoom and the zoom reset.
+//
+// Ranges with a few times more rows than pixels are reduced with LTTB. Larger ones are served from a pyramid of
+// buckets holding the rows with the smallest and the largest value, so the cost only depends on the chart width.
+// Level k has buckets of 2^(k + 1) rows.
+//
+// The pyramid is a child of the series and is deleted with it.
+
+class SeriesPyramid : public QObject {
+  Q_OBJECT
+ public:
+  SeriesPyramid(QChart* chart, QXYSeries* series, const QVector<qint64>& dates, const QVector<double>& values);
+
+  void set_data(const QVector<qint64>& dates, const QVector<double>& values);
+
+  // the pyramid attached to a series or nullptr
+
+  static auto find(const QXYSeries* series) -> SeriesPyramid*;
+
+ private:
+  QChart* const chart;
+
+  QXYSeries* const series;
+
+  QVector<qint64> dates;
+  QVector<double> values;
+
+  // rows of the extremes of every bucket in chronological order. Two per bucket.
+
+  std::vector<QVector<int>> levels;
+
+  void build();
+
+  void refresh();
+
+  [[nodiscard]] auto points(const int& first, const int& last, const int& resolution) const -> QVector<QPointF>;
+};
+
+#endif
@@ -1,19 +1,27 @@
 #include "table.hpp"
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariantList>
+#include <algorithm>
+#include <numeric>
+#include <string_view>
 #include "chart_funcs.hpp"
+#include "csv_funcs.hpp"
+#include "db_funcs.hpp"
 #include "effects.hpp"
+#include "math.hpp"
 
 Table::Table(QWidget* parent)
     : QWidget(parent),
       model(nullptr),
       chart1(new QChart()),
       chart2(new QChart()),
-      callout1(new Callout(chart1)),
-      callout2(new Callout(chart2)) {
+      binding1(chart1),
+      binding2(chart2),
+      crosshair1(chart1, binding1.index()),
+      crosshair2(chart2, binding2.index(), [](const double& value) { return QString::number(value, 'f', 2) + "%"; }) {
   setupUi(this);
 
-  callout1->hide();
-  callout2->hide();
-
   table_view->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
   table_view->verticalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
   table_view->installEventFilter(this);
@@ -34,8 +42,9 @@ Table::Table(QWidget* parent)
   connect(radio_chart2, &QRadioButton::toggled, this, &Table::on_chart_selection);
 
   connect(spinbox_days, QOverload<int>::of(&QSpinBox::valueChanged), [&](int value) {
-    clear_chart(chart2);
-    make_chart2();
+    if (instrument != nullptr) {
+      make_chart2();
+    }
   });
 
   // chart 1 settings
@@ -47,6 +56,8 @@ Table::Table(QWidget* parent)
   chart_view1->setRenderHint(QPainter::Antialiasing);
   chart_view1->setRubberBand(QChartView::RectangleRubberBand);
 
+  crosshair1.watch(chart_view1);
+
   // chart 2 settings
 
   chart2->setTheme(QChart::ChartThemeLight);
@@ -56,6 +67,13 @@ Table::Table(QWidget* parent)
   chart_view2->setRenderHint(QPainter::Antialiasing);
   chart_view2->setRubberBand(QChartView::RectangleRubberBand);
 
+  crosshair2.watch(chart_view2);
+
+  // the axes live as long as the charts. Only the series change.
+
+  add_axes_to_chart(chart1, QLocale().currencySymbol());
+  add_axes_to_chart(chart2, "%");
+
   // select the default chart
 
   if (radio_chart1->isChecked()) {
@@ -73,8 +91,66 @@ Table::Table(QWidget* parent)
 
 void Table::set_database(const QSqlDatabase& database) {
   db = database;
+}
+
+auto Table::bind(Instrument* new_instrument, const bool& discard_edits) -> bool {
+  if (model != nullptr) {
+    // The edits done in the previous instrument are kept before its model is released. When they can not be saved the
+    // instrument stays bound so they are not lost, unless the caller chose to discard them.
+
+    if (!save()) {
+      if (!discard_edits) {
+        return false;
+      }
+
+      reload_series();
+    }
+
+    table_view->setModel(nullptr);
+
+    delete model;
+
+    model = nullptr;
+  }
+
+  crosshair1.hide();
+  crosshair2.hide();
+
+  instrument = new_instrument;
+
+  // the series of the charts are kept and receive the points of the new instrument
+
+  if (instrument == nullptr) {
+    clear_charts();
+
+    return true;
+  }
+
+  model = new Model(db, this);
+
+  // the series is rebuilt once after a burst of changes
+
+  connect(model, &QSqlTableModel::dataChanged, this, &Table::on_model_changed);
+  connect(model, &QSqlTableModel::rowsInserted, this, &Table::on_model_changed);
+  connect(model, &QSqlTableModel::rowsRemoved, this, &Table::on_model_changed);
+  connect(model, &QSqlTableModel::modelReset, this, &Table::on_model_changed);
+
+  // rows removed with manual submit stay in the model and only their header changes
+
+  connect(model, &QSqlTableModel::headerDataChanged, this, &Table::on_model_changed);
+
+  init_model();
+
+  // the series held by the instrument is already up to date
+
+  series_outdated = false;
+  series_in_model_order = false;
+
+  unsaved_returns_from = -1;
 
-  model = new Model(db);
+  update_charts();
+
+  return true;
 }
 
 void Table::set_chart1_title(const QString& title) {
@@ -86,7 +162,13 @@ void Table::set_chart2_title(const QString& title) {
 }
 
 void Table::init_model() {
-  model->setTable(name);
+  if (instrument->instrument_id < 0) {
+    model->setTable(instrument->name);
+  } else {
+    model->setTable("prices");
+    model->setFilter("instrument_id = " + QString::number(instrument->instrument_id));
+  }
+
   model->setEditStrategy(QSqlTableModel::OnManualSubmit);
   model->setSort(1, Qt::DescendingOrder);
 
@@ -104,7 +186,7 @@ void Table::init_model() {
 }
 
 auto Table::eventFilter(QObject* object, QEvent* event) -> bool {
-  if (event->type() == QEvent::KeyPress) {
+  if (event->type() == QEvent::KeyPress && model != nullptr) {
     auto* keyEvent = dynamic_cast<QKeyEvent*>(event);
 
     if (keyEvent->key() == Qt::Key_Delete) {
@@ -155,43 +237,202 @@ auto Table::eventFilter(QObject* object, QEvent* event) -> bool {
       auto s_model = table_view->selectionModel();
 
       if (s_model->hasSelection()) {
-        auto clipboard = QGuiApplication::clipboard();
+        auto selection_range = s_model->selection().constFirst();
 
-        auto table_str = clipboard->text();
-        auto table_rows = table_str.split(QRegExp("[\r\n]"), QString::SkipEmptyParts);
+        paste(QGuiApplication::clipboard()->text(), selection_range.top(), selection_range.left());
+      }
 
-        auto selection_range = s_model->selection().constFirst();
+      return true;
+    }
 
-        auto first_row = selection_range.top();
-        auto first_col = selection_range.left();
+    return QObject::eventFilter(object, event);
+  }
 
-        for (int i = 0; i < table_rows.size(); i++) {
-          auto model_i = first_row + i;
+  return QObject::eventFilter(object, event);
+}
 
-          if (model_i < model->rowCount()) {
-            auto row_cols = table_rows[i].split("\t");
+void Table::paste(const QString& text, const int& first_row, const int& first_col) {
+  // The whole block is parsed and validated before anything is written. Then it goes to the database in a single
+  // transaction and the model is selected only once. Rows past the last one are appended to the table.
 
-            for (int j = 0; j < row_cols.size(); j++) {
-              auto model_j = first_col + j;
+  auto table_rows = text.split(QRegExp("[\r\n]"), QString::SkipEmptyParts);
 
-              if (model_j < model->columnCount()) {
-                model->setData(model->index(model_i, model_j), row_cols[j], Qt::EditRole);
-              }
-            }
-          }
-        }
+  if (table_rows.empty()) {
+    return;
+  }
+
+  QVector<QStringList> cells;
+
+  cells.reserve(table_rows.size());
+
+  for (auto& row : table_rows) {
+    cells.append(row.split("\t"));
+
+    if (cells.last().size() != cells.first().size()) {
+      qDebug() << "the pasted rows do not have the same number of columns";
+
+      return;
+    }
+  }
+
+  // only the date and the value columns can receive data. Cells outside of them are ignored.
+
+  const int col_begin = std::max(first_col, 1);
+  const int col_end = std::min(first_col + cells.first().size(), 3);
+
+  if (col_begin >= col_end) {
+    return;
+  }
+
+  QVector<QVariantList> columns(col_end - col_begin);
+
+  for (auto& column : columns) {
+    column.reserve(cells.size());
+  }
+
+  for (int i = 0; i < cells.size(); i++) {
+    for (int c = col_begin; c < col_end; c++) {
+      const auto field = cells[i][c - first_col].toUtf8();
+      const auto view = std::string_view(field.constData(), field.size());
+
+      qint64 date = 0;
+      double value = 0.0;
+
+      if (c == 1 && parse_date(view, date)) {
+        columns[c - col_begin].append(date);
+      } else if (c > 1 && parse_number(view, value, locale.decimalPoint().toLatin1())) {
+        columns[c - col_begin].append(value);
+      } else {
+        qDebug() << "nothing was pasted because of the invalid value" << cells[i][c - first_col] << "in row" << i + 1;
+
+        return;
       }
+    }
+  }
 
-      return true;
+  if (model->isDirty() && !model->submitAll()) {
+    qDebug() << "failed to save table " + instrument->name.toUtf8() + " to the database";
+
+    return;
+  }
+
+  // the keys of the existing rows are only known after every row was fetched
+
+  while (model->canFetchMore()) {
+    model->fetchMore();
+  }
+
+  const int n_rows = model->rowCount();
+  const bool long_format = instrument->instrument_id >= 0;
+
+  // Appended rows get their date from the pasted block. Without it they would have no date, and in the long format
+  // the date is part of the primary key.
+
+  if (first_row + cells.size() > n_rows && col_begin > 1) {
+    qDebug() << "nothing was pasted because the rows past the end of the table need a date column";
+
+    return;
+  }
+
+  QStringList fields;
+
+  for (int c = col_begin; c < col_end; c++) {
+    fields.append(model->record().fieldName(c));
+  }
+
+  QVector<QVariantList> updated(columns.size());
+  QVector<QVariantList> appended(columns.size());
+
+  QVariantList keys;
+  QVariantList instrument_ids;
+
+  for (int i = 0; i < cells.size(); i++) {
+    const int row = first_row + i;
+
+    if (row < n_rows) {
+      for (int k = 0; k < columns.size(); k++) {
+        updated[k].append(columns[k][i]);
+      }
+
+      keys.append(long_format ? model->raw_date(row) : model->raw_id(row));
+    } else {
+      for (int k = 0; k < columns.size(); k++) {
+        appended[k].append(columns[k][i]);
+      }
+
+      instrument_ids.append(instrument->instrument_id);
     }
+  }
 
-    return QObject::eventFilter(object, event);
+  if (!db.transaction()) {
+    qDebug() << db.lastError().text().toUtf8();
+
+    return;
   }
 
-  return QObject::eventFilter(object, event);
+  auto query = QSqlQuery(db);
+
+  bool ok = true;
+
+  if (!keys.empty()) {
+    if (long_format) {
+      query.prepare("update prices set " + fields.join(" = ?, ") + " = ? where instrument_id = " +
+                    QString::number(instrument->instrument_id) + " and date = ?");
+    } else {
+      query.prepare("update " + instrument->name + " set " + fields.join(" = ?, ") + " = ? where id = ?");
+    }
+
+    for (auto& column : updated) {
+      query.addBindValue(column);
+    }
+
+    query.addBindValue(keys);
+
+    ok = query.execBatch();
+  }
+
+  if (ok && !instrument_ids.empty()) {
+    const auto placeholders = QString("?, ").repeated(fields.size() - 1) + "?";
+
+    if (long_format) {
+      // an existing row with the same date is reported as a conflict instead of being overwritten
+
+      query.prepare("insert into prices (instrument_id, " + fields.join(", ") + ") values (?, " + placeholders + ")");
+
+      query.addBindValue(instrument_ids);
+    } else {
+      query.prepare("insert into " + instrument->name + " (" + fields.join(", ") + ") values (" + placeholders + ")");
+    }
+
+    for (auto& column : appended) {
+      query.addBindValue(column);
+    }
+
+    ok = query.execBatch();
+  }
+
+  if (!ok) {
+    qDebug() << "failed to paste into table " + instrument->name.toUtf8() + ": " + query.lastError().text().toUtf8();
+
+    db.rollback();
+
+    return;
+  }
+
+  db.commit();
+
+  model->select();
+
+  // the returns of the pasted rows are calculated again like after any other edit
+
+  refresh_series();
 }
 
 void Table::remove_selected_rows() {
+  if (model == nullptr) {
+    return;
+  }
+
   auto s_model = table_view->selectionModel();
 
   if (s_model->hasSelection()) {
@@ -225,37 +466,10 @@ void Table::remove_selected_rows() {
 }
 
 void Table::clear_charts() {
-  chart1->removeAllSeries();
-  chart2->removeAllSeries();
+  scheduler.cancel();
 
-  for (auto& axis : chart1->axes()) {
-    chart1->removeAxis(axis);
-  }
-
-  for (auto& axis : chart2->axes()) {
-    chart2->removeAxis(axis);
-  }
-}
-
-void Table::on_chart_mouse_hover(const QPointF& point, bool state, Callout* c, const QString& name) {
-  if (state) {
-    auto qdt = QDateTime();
-
-    qdt.setMSecsSinceEpoch(point.x());
-
-    c->setText(QString("Curve: %1\nDate: %2\nReturn: %3")
-                   .arg(name, qdt.toString("dd/MM/yyyy"), QString::number(point.y(), 'f', 2)));
-
-    c->setAnchor(point);
-
-    c->setZValue(11);
-
-    c->updateGeometry();
-
-    c->show();
-  } else {
-    c->hide();
-  }
+  binding1.clear();
+  binding2.clear();
 }
 
 void Table::reset_zoom() {
@@ -285,11 +499,32 @@ void Table::on_chart_selection(const bool& state) {
 }
 
 void Table::on_add_row() {
+  if (model == nullptr) {
+    return;
+  }
+
   auto rec = model->record();
 
   rec.setGenerated("id", false);
 
-  rec.setValue("date", int(QDateTime::currentSecsSinceEpoch()));
+  if (instrument->instrument_id >= 0) {
+    rec.setValue("instrument_id", instrument->instrument_id);
+  }
+
+  // The date is part of the primary key in the long format, so the new row gets one no other row has. The rows not
+  // fetched yet are older because the model is sorted by date in descending order.
+
+  qint64 latest = 0;
+
+  for (int n = 0; n < model->rowCount(); n++) {
+    latest = std::max(latest, model->raw_date(n));
+  }
+
+  constexpr qint64 day_msecs = 86400LL * 1000;
+
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+  rec.setValue("date", (model->rowCount() > 0 && latest >= now) ? latest + day_msecs : now);
 
   rec.setGenerated("value", true);
   rec.setGenerated("accumulated", true);
@@ -301,169 +536,335 @@ void Table::on_add_row() {
   rec.setValue("accumulated_return_perc", 0.0);
 
   if (!model->insertRecord(0, rec)) {
-    qDebug() << "failed to add row to table " + name;
+    qDebug() << "failed to add row to table " + instrument->name;
   }
 }
 
-void Table::calculate_accumulated_sum(const QString& column_name) {
-  QVector<double> list_values;
-  QVector<double> accu;
-
-  for (int n = 0; n < model->rowCount(); n++) {
-    list_values.append(model->record(n).value(column_name).toDouble());
+void Table::on_model_changed() {
+  if (series_outdated) {
+    return;
   }
 
-  if (!list_values.empty()) {
-    std::reverse(list_values.begin(), list_values.end());
+  series_outdated = true;
+
+  QTimer::singleShot(0, this, [&]() {
+    if (series_outdated && instrument != nullptr) {
+      refresh_series();
+    }
+  });
+}
+
+void Table::refresh_series() {
+  auto& series = instrument->series;
+
+  int first_row = 0;
+  int last_row = 0;
+  bool structural = true;
+
+  const bool edited = model->take_dirty_rows(first_row, last_row, structural);
 
-    // cumulative sum
+  int first = series.size();
+  int last = -1;
 
-    accu.resize(list_values.size());
+  bool changed = false;
 
-    std::partial_sum(list_values.begin(), list_values.end(), accu.begin());
+  if (edited && !structural && series_in_model_order && series.size() == model->rowCount()) {
+    // Only values were edited and each model row is still a single point of the series
 
-    std::reverse(accu.begin(), accu.end());
+    const int n_rows = model->rowCount();
+
+    for (int row = first_row; row <= last_row; row++) {
+      const int idx = n_rows - 1 - row;
+
+      series.values[idx] = model->raw_value(row, 2);
+
+      first = std::min(first, idx);
+      last = std::max(last, idx);
+    }
+
+    // the return of the next point also depends on the edited value
+
+    last++;
+
+    changed = true;
+  } else {
+    const auto previous = series;
 
-    for (int n = 0; n < model->rowCount(); n++) {
-      auto rec = model->record(n);
+    update_series();
 
-      rec.setGenerated("accumulated_" + column_name, true);
+    // The returns calculated for the points before the first difference are still valid
 
-      rec.setValue("accumulated_" + column_name, accu[n]);
+    first = 0;
 
-      model->setRecord(n, rec);
+    while (first < series.size() && first < previous.size() && series.dates[first] == previous.dates[first] &&
+           series.values[first] == previous.values[first]) {
+      first++;
     }
+
+    std::copy(previous.return_perc.begin(), previous.return_perc.begin() + first, series.return_perc.begin());
+    std::copy(previous.accumulated_return_perc.begin(), previous.accumulated_return_perc.begin() + first,
+              series.accumulated_return_perc.begin());
+
+    last = series.size() - 1;
+
+    changed = first < series.size() || series.size() != previous.size();
+  }
+
+  series_outdated = false;
+
+  if (!changed) {
+    return;
   }
+
+  percent_returns(series.values, series.return_perc, first, last);
+  accumulated_return(series.return_perc, series.accumulated_return_perc, first);
+
+  unsaved_returns_from = (unsaved_returns_from < 0) ? first : std::min(unsaved_returns_from, first);
+
+  update_charts();
 }
 
-void Table::calculate_accumulated_product(const QString& column_name) {
-  QVector<double> list_values;
-  QVector<double> accu;
+void Table::reload_series() {
+  // The edited values are already in the series. Its returns are calculated again from the values read because the
+  // ones in the database may belong to edits that were only partly saved.
+
+  model->revertAll();
+
+  if (!model->select()) {
+    qDebug() << "failed to read table " + instrument->name.toUtf8() + " again after discarding its edits";
+
+    qDebug() << model->lastError().text().toUtf8();
+
+    return;
+  }
+
+  update_series();
+
+  auto& series = instrument->series;
+
+  series.return_perc = percent_returns(series.values);
+  series.accumulated_return_perc = accumulated_return(series.return_perc);
+
+  unsaved_returns_from = -1;
+}
+
+void Table::update_series() {
+  auto& series = instrument->series;
+
+  // QSqlTableModel fetches rows lazily. The series must see all of them.
+
+  while (model->canFetchMore()) {
+    model->fetchMore();
+  }
+
+  int n_rows = 0;
 
   for (int n = 0; n < model->rowCount(); n++) {
-    list_values.append(model->record(n).value(column_name).toDouble());
+    n_rows += model->is_removed(n) ? 0 : 1;
   }
 
-  if (!list_values.empty()) {
-    std::reverse(list_values.begin(), list_values.end());
+  series.resize(n_rows);
 
-    for (auto& value : list_values) {
-      value = value * 0.01 + 1.0;
+  // The model is sorted by date in descending order. The series is filled from the end.
+
+  for (int n = 0, idx = n_rows - 1; n < model->rowCount(); n++) {
+    if (model->is_removed(n)) {
+      continue;
     }
 
-    // cumulative product
+    series.ids[idx] = model->raw_id(n);
+    series.dates[idx] = model->raw_date(n);
+    series.values[idx] = model->raw_value(n, 2);
+    series.return_perc[idx] = model->raw_value(n, 3);
+    series.accumulated_return_perc[idx] = model->raw_value(n, 4);
 
-    accu.resize(list_values.size());
+    idx--;
+  }
 
-    std::partial_sum(list_values.begin(), list_values.end(), accu.begin(), std::multiplies<>());
+  series_in_model_order = n_rows == model->rowCount() && std::is_sorted(series.dates.begin(), series.dates.end());
 
-    for (auto& value : accu) {
-      value = (value - 1.0) * 100;
-    }
+  // Edited dates are only sorted by the model after the next select
 
-    std::reverse(accu.begin(), accu.end());
+  if (!std::is_sorted(series.dates.begin(), series.dates.end())) {
+    QVector<int> order(n_rows);
 
-    for (int n = 0; n < model->rowCount(); n++) {
-      auto rec = model->record(n);
+    std::iota(order.begin(), order.end(), 0);
 
-      rec.setGenerated("accumulated_" + column_name, true);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return series.dates[a] < series.dates[b]; });
 
-      rec.setValue("accumulated_" + column_name, accu[n]);
+    const auto unsorted = series;
 
-      model->setRecord(n, rec);
+    for (int n = 0; n < n_rows; n++) {
+      series.ids[n] = unsorted.ids[order[n]];
+      series.dates[n] = unsorted.dates[order[n]];
+      series.values[n] = unsorted.values[order[n]];
+      series.return_perc[n] = unsorted.return_perc[order[n]];
+      series.accumulated_return_perc[n] = unsorted.accumulated_return_perc[order[n]];
     }
   }
+
+  series_outdated = false;
 }
 
 void Table::calculate() {
-  if (model->rowCount() == 0) {
+  if (instrument == nullptr) {
     return;
   }
 
-  auto rec = model->record(model->rowCount() - 1);
+  auto& series = instrument->series;
+  const auto& name = instrument->name;
+  const auto& instrument_id = instrument->instrument_id;
+
+  // Pending edits have to reach the database before the returns are written to it
+
+  if (model->isDirty() && !model->submitAll()) {
+    qDebug() << "failed to save table " + name.toUtf8() + " to the database";
 
-  rec.setGenerated("net_return", true);
-  rec.setGenerated("net_return_perc", true);
+    qDebug() << model->lastError().text().toUtf8();
 
-  rec.setValue("net_return", 0);
-  rec.setValue("net_return_perc", 0);
+    return;
+  }
 
-  model->setRecord(model->rowCount() - 1, rec);
+  // the database can not take the logarithm of the returns of a table with values that are zero or negative
 
-  for (int n = model->rowCount() - 2; n >= 0; n--) {
-    double value = model->record(n).value("value").toDouble();
-    double last_value = model->record(n + 1).value("value").toDouble();
+  if (calculate_in_db && values_are_positive(db, name, instrument_id)) {
+    const bool calculated = (instrument_id < 0) ? calculate_returns_in_db(db, {name})
+                                                : calculate_instrument_returns_in_db(db, instrument_id);
 
-    double return_perc = 100 * (value - last_value) / last_value;
+    if (calculated) {
+      model->select();
 
-    auto rec = model->record(n);
+      update_series();
 
-    rec.setGenerated("return_perc", true);
+      unsaved_returns_from = -1;
+    }
 
-    rec.setValue("return_perc", return_perc);
+    update_charts();
 
-    model->setRecord(n, rec);
+    return;
   }
 
-  calculate_accumulated_product("return_perc");
+  if (series_outdated) {
+    update_series();
+  }
 
-  clear_charts();
+  if (series.empty()) {
+    return;
+  }
 
-  make_chart1();
-  make_chart2();
-}
+  series.return_perc = percent_returns(series.values);
+  series.accumulated_return_perc = accumulated_return(series.return_perc);
 
-void Table::make_chart1() {
-  chart1->setTitle(name.toUpper());
+  const bool saved =
+      (instrument_id < 0) ? save_returns(db, name, series) : save_instrument_returns(db, instrument_id, series);
 
-  add_axes_to_chart(chart1, QLocale().currencySymbol());
+  if (saved) {
+    model->select();
 
-  auto s1 = add_series_to_chart(chart1, model, "Value", "value");
+    // the series already holds what the model has just read
 
-  connect(s1, &QLineSeries::hovered, this,
-          [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout1, s1->name()); });
+    series_outdated = false;
+
+    unsaved_returns_from = -1;
+  }
+
+  update_charts();
 }
 
-void Table::make_chart2() {
-  chart2->setTitle(name.toUpper());
+auto Table::save() -> bool {
+  if (instrument == nullptr) {
+    return false;
+  }
 
-  add_axes_to_chart(chart2, "%");
+  const auto& series = instrument->series;
 
-  QVector<int> dates;
-  QVector<double> vreturn;
-  QVector<double> accumulated_return;
+  if (model->isDirty() && !model->submitAll()) {
+    qDebug() << "failed to save table " + instrument->name.toUtf8() + " to the database";
 
-  for (int n = 0; n < model->rowCount() && dates.size() < spinbox_days->value(); n++) {
-    auto qdt = QDateTime::fromString(model->record(n).value("date").toString(), "dd/MM/yyyy");
+    qDebug() << model->lastError().text().toUtf8();
 
-    dates.append(qdt.toSecsSinceEpoch());
-    vreturn.append(model->record(n).value("return_perc").toDouble());
+    return false;
   }
 
-  if (dates.empty()) {
-    return;
+  // the ids of the inserted rows are only known after they were submitted
+
+  if (series_outdated) {
+    refresh_series();
   }
 
-  std::reverse(vreturn.begin(), vreturn.end());
+  if (unsaved_returns_from < 0 || unsaved_returns_from >= series.size()) {
+    unsaved_returns_from = -1;
+
+    return true;
+  }
+
+  // only the returns changed by the edits are written
+
+  const auto changed = series.mid(unsaved_returns_from);
 
-  for (auto& value : vreturn) {
-    value = value * 0.01 + 1.0;
+  const bool saved = (instrument->instrument_id < 0)
+                         ? save_returns(db, instrument->name, changed)
+                         : save_instrument_returns(db, instrument->instrument_id, changed);
+
+  if (saved) {
+    unsaved_returns_from = -1;
+
+    model->select();
+
+    series_outdated = false;
   }
 
-  accumulated_return.resize(vreturn.size());
+  return saved;
+}
 
-  std::partial_sum(vreturn.begin(), vreturn.end(), accumulated_return.begin(), std::multiplies<>());
+void Table::update_charts() {
+  if (instrument == nullptr) {
+    clear_charts();
 
-  for (auto& value : accumulated_return) {
-    value = (value - 1.0) * 100;
+    return;
   }
 
-  std::reverse(accumulated_return.begin(), accumulated_return.end());
+  make_chart1();
+  make_chart2();
+}
+
+void Table::make_chart1() {
+  const auto& series = instrument->series;
+
+  chart1->setTitle(instrument->name.toUpper());
+
+  binding1.begin();
+
+  binding1.set_line("Value", series.dates, series.values);
+
+  binding1.end();
+}
+
+void Table::make_chart2() {
+  // the worker gets a copy of the series
+
+  const auto series = instrument->series;
+  const auto title = instrument->name.toUpper();
+
+  const int days = spinbox_days->value();
+
+  scheduler.schedule([this, series, title, days](
+                         const RecomputeScheduler::IsCancelled& is_cancelled) -> RecomputeScheduler::Publish {
+    const auto start = series.tail_start(days);
 
-  perc_chart_oldest_date = dates[dates.size() - 1];
+    const auto dates = series.dates.mid(start);
+    const auto values = accumulated_return(series.return_perc.mid(start));
 
-  auto s1 = add_series_to_chart(chart2, dates, accumulated_return, "Accumulated Return");
+    return [this, title, dates, values]() {
+      chart2->setTitle(title);
 
-  connect(s1, &QLineSeries::hovered, this,
-          [=](const QPointF& point, bool state) { on_chart_mouse_hover(point, state, callout2, s1->name()); });
+      binding2.begin();
+
+      if (!dates.empty()) {
+        binding2.set_line("Accumulated Return", dates, values);
+      }
+
+      binding2.end();
+    };
+  });
 }
@@ -7,8 +7,11 @@
 #include <QSqlTableModel>
 #include <QTableView>
 #include <QtCharts>
-#include "callout.hpp"
+#include "chart_binding.hpp"
+#include "chart_crosshair.hpp"
+#include "instrument.hpp"
 #include "model.hpp"
+#include "recompute_scheduler.hpp"
 #include "ui_table.h"
 
 class Table : public QWidget, protected Ui::Table {
@@ -16,48 +19,72 @@ class Table : public QWidget, protected Ui::Table {
  public:
   explicit Table(QWidget* parent = nullptr);
 
-  QString name;
-  Model* model;
+  Instrument* instrument = nullptr;  // the one being edited
+  Model* model = nullptr;
+
+  bool calculate_in_db = false;
 
   void set_database(const QSqlDatabase& database);
+  // Returns false and keeps the current instrument when its edits could not be saved, unless they may be discarded
+
+  auto bind(Instrument* new_instrument, const bool& discard_edits = false) -> bool;
   void set_chart1_title(const QString& title);
   void set_chart2_title(const QString& title);
   void clear_charts();
   void calculate();
+  auto save() -> bool;
+  void update_series();
+  void update_charts();
 
   virtual void init_model();
 
- signals:
-  void hideProgressBar();
-  void newChartMouseHover(const QPointF& point);
-
  protected:
   QSqlDatabase db;
 
   QChart* const chart1;
   QChart* const chart2;
 
-  Callout* const callout1;
-  Callout* const callout2;
+  ChartBinding binding1;
+  ChartBinding binding2;
+
+  ChartCrosshair crosshair1;
+  ChartCrosshair crosshair2;
 
   auto eventFilter(QObject* object, QEvent* event) -> bool override;
   void remove_selected_rows();
+  void paste(const QString& text, const int& first_row, const int& first_col);
   void reset_zoom();
-  void calculate_accumulated_sum(const QString& column_name);
-  void calculate_accumulated_product(const QString& column_name);
 
-  static void on_chart_mouse_hover(const QPointF& point, bool state, Callout* c, const QString& name);
   void on_chart_selection(const bool& state);
 
  private:
   QLocale locale;
 
-  int perc_chart_oldest_date = 0;
+  bool series_outdated = false;
+
+  // true when the series has a point for every model row in the reversed model order
+
+  bool series_in_model_order = false;
+
+  // first point whose returns were recalculated after an edit but not written to the database. Negative when none.
+
+  int unsaved_returns_from = -1;
+
+  // chart 2 follows the days spinbox, so its returns are calculated away from the gui thread. Declared last so the
+  // running jobs are finished before the rest of the widget goes away.
+
+  RecomputeScheduler scheduler;
 
   void make_chart1();
   void make_chart2();
 
   void on_add_row();
+  void on_model_changed();
+  void refresh_series();
+
+  // throws away the edits that could not be saved. The series goes back to what the database holds.
+
+  void reload_series();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef TIME_SERIES_HPP
+#define TIME_SERIES_HPP
+
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+#include <algorithm>
+
+// Columns of a stock table stored contiguously in chronological order (oldest row first). Dates are milliseconds since
+// epoch.
+
+struct TimeSeries {
+  QVector<qint64> ids;
+  QVector<qint64> dates;
+  QVector<double> values;
+  QVector<double> return_perc;
+  QVector<double> accumulated_return_perc;
+
+  [[nodiscard]] auto size() const -> int { return dates.size(); }
+
+  [[nodiscard]] auto empty() const -> bool { return dates.empty(); }
+
+  // index of the first element of the last n rows
+
+  [[nodiscard]] auto tail_start(const int& n) const -> int { return std::max(0, size() - n); }
+
+  // access to a value column using the same name it has in the database
+
+  [[nodiscard]] auto column(const QString& name) const -> const QVector<double>& {
+    if (name == "return_perc") {
+      return return_perc;
+    }
+
+    if (name == "accumulated_return_perc") {
+      return accumulated_return_perc;
+    }
+
+    return values;
+  }
+
+  // the rows from start to the end
+
+  [[nodiscard]] auto mid(const int& start) const -> TimeSeries {
+    return {ids.mid(start), dates.mid(start), values.mid(start), return_perc.mid(start),
+            accumulated_return_perc.mid(start)};
+  }
+
+  void clear() {
+    ids.clear();
+    dates.clear();
+    values.clear();
+    return_perc.clear();
+    accumulated_return_perc.clear();
+  }
+
+  void resize(const int& n) {
+    ids.resize(n);
+    dates.resize(n);
+    values.resize(n);
+    return_perc.resize(n);
+    accumulated_return_perc.resize(n);
+  }
+};
+
+Q_DECLARE_METATYPE(TimeSeries)
+
+#endif